@@ -0,0 +1,126 @@
+///
+/// @copyrightblock
+///
+///   NPOSL-3.0 License
+///
+///   Copyright(c) 2021 Mtys Lrnt-Nyeste
+///
+///   Licensed under the Non-Profit Open Software License, version 3.0 (the "License"); you may not use this file except
+///   in compliance with the License. You may obtain a copy of the License at:
+///
+///   https://opensource.org/licenses/NPOSL-3.0
+///
+///   Unless required by applicable law or agreed to in writing, software distributed under the License is distributed
+///   on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for
+///   the specific language governing permissionsand limitations under the License.
+///
+/// @endcopyrightblock
+///
+
+#pragma once
+
+/// @brief C interface of the library, for host codes not able to use the C++ templates directly (e.g. Fortran through
+///        "iso_c_binding"). Grids are accessed through opaque handles, instantiated for 1 to "DIRE_MAX_DIM" dimensions
+///        and payloads of 1 to "DIRE_MAX_NUM_FIELDS" doubles. The compressed arrays of a grid are exposed in place as
+///        raw pointers, without copying them.
+///
+///        Storage ids and cell ids are zero based; the storage id of a cell is it's linearized id, axis 0 being the
+///        fastest varying (the column-major order of Fortran). Functions returning "dire_status" report errors by
+///        their return value, and the message of the last error of the calling thread is returned by
+///        "dire_get_last_error()".
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DIRE_MAX_DIM 3        ///< The maximal dimensionality of a grid
+#define DIRE_MAX_NUM_FIELDS 8 ///< The maximal number of doubles in the payload of a data
+
+/// @brief The result of a call.
+typedef enum dire_status
+{
+    DIRE_OK = 0,                ///< The call succeeded
+    DIRE_INVALID_ARGUMENT = 1,  ///< A null pointer, zero size or unsupported instantiation was provided
+    DIRE_OUT_OF_RANGE = 2,      ///< An invalid cell id was provided
+    DIRE_NOT_COMPRESSED = 3,    ///< The grid has to be compressed
+    DIRE_OUT_OF_MEMORY = 4,     ///< An allocation failed
+    DIRE_ERROR = 5              ///< Any other error
+} dire_status;
+
+/// @brief Opaque handle of a grid.
+typedef struct dire_grid dire_grid;
+
+/// @brief The compressed arrays of a grid. The pointers are owned by the grid, and are valid until the grid is
+///        modified ("dire_grid_add*()", "dire_grid_clear()", "dire_grid_compress()") or destroyed.
+typedef struct dire_grid_view
+{
+    size_t num_cells;                     ///< The gross number of cells
+    size_t num_data;                      ///< The number of data
+    size_t num_fields;                    ///< The number of doubles in the payload of a data
+    const size_t* num_data_per_cell;      ///< The number of data in each cell, indexed by storage id
+    const size_t* first_data_id_per_cell; ///< The id of the first data of each cell, indexed by storage id
+    const double* data;                   ///< The payloads in the compressed order, "num_fields" doubles per data
+} dire_grid_view;
+
+/// @brief Creates a grid.
+/// @param dim The dimensionality of the grid in [1, DIRE_MAX_DIM].
+/// @param grid_size The number of cells along each dimension ("dim" values).
+/// @param num_fields The number of doubles in the payload of a data in [1, DIRE_MAX_NUM_FIELDS].
+/// @param buff_size The number of data, that can be stored without reallocation.
+/// @param grid Receives the handle of the created grid, to be released by "dire_grid_destroy()".
+/// @return The status of the call.
+dire_status dire_grid_create(size_t dim, const size_t* grid_size, size_t num_fields, size_t buff_size,
+                             dire_grid** grid);
+
+/// @brief Destroys a grid. Invalidates all of it's views. Null handles are ignored.
+/// @param grid The handle of the grid.
+void dire_grid_destroy(dire_grid* grid);
+
+/// @brief Returns the dimensionality and the number of fields a grid was created with.
+/// @param grid The handle of the grid.
+/// @param dim Receives the dimensionality.
+/// @param num_fields Receives the number of doubles in the payload of a data.
+/// @return The status of the call.
+dire_status dire_grid_get_layout(const dire_grid* grid, size_t* dim, size_t* num_fields);
+
+/// @brief Adds a data to a cell of a grid. Makes the grid uncompressed.
+/// @param grid The handle of the grid.
+/// @param cell_id The id of the cell ("dim" values).
+/// @param fields The payload of the data ("num_fields" values).
+/// @return The status of the call.
+dire_status dire_grid_add(dire_grid* grid, const size_t* cell_id, const double* fields);
+
+/// @brief Adds multiple data to a grid in one call. Makes the grid uncompressed. If a cell id is invalid, the data
+///        before it are left in the grid.
+/// @param grid The handle of the grid.
+/// @param count The number of data.
+/// @param cell_ids The ids of the cells ("count" times "dim" values, the ids of a data following each other).
+/// @param fields The payloads ("count" times "num_fields" values, the fields of a data following each other).
+/// @return The status of the call.
+dire_status dire_grid_add_n(dire_grid* grid, size_t count, const size_t* cell_ids, const double* fields);
+
+/// @brief Clears all buffered data from a grid. Makes the grid uncompressed.
+/// @param grid The handle of the grid.
+/// @return The status of the call.
+dire_status dire_grid_clear(dire_grid* grid);
+
+/// @brief Converts a grid into the compressed format.
+/// @param grid The handle of the grid.
+/// @return The status of the call.
+dire_status dire_grid_compress(dire_grid* grid);
+
+/// @brief Returns the compressed arrays of a grid. The grid has to be compressed.
+/// @param grid The handle of the grid.
+/// @param view Receives the arrays.
+/// @return The status of the call.
+dire_status dire_grid_get_view(const dire_grid* grid, dire_grid_view* view);
+
+/// @brief Returns the message of the last error on the calling thread.
+/// @return The message, or an empty string, if no error happened. Valid until the next failing call on the thread.
+const char* dire_get_last_error(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
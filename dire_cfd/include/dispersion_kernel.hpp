@@ -0,0 +1,503 @@
+///
+/// @copyrightblock
+///
+///   NPOSL-3.0 License
+///
+///   Copyright(c) 2021 Mtys Lrnt-Nyeste
+///
+///   Licensed under the Non-Profit Open Software License, version 3.0 (the "License"); you may not use this file except
+///   in compliance with the License. You may obtain a copy of the License at:
+///
+///   https://opensource.org/licenses/NPOSL-3.0
+///
+///   Unless required by applicable law or agreed to in writing, software distributed under the License is distributed
+///   on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for
+///   the specific language governing permissionsand limitations under the License.
+///
+/// @endcopyrightblock
+///
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace dire {
+
+/// @brief The Gaussian dispersion kernel, truncated to a compact support and shifted to vanish at it's boundary:
+///        w(r) = (exp(-r^2 / (2 * sigma^2)) - exp(-R^2 / (2 * sigma^2))) / (1 - exp(-R^2 / (2 * sigma^2))), for r < R.
+///        The kernel is evaluated as a function of the squared distance, so no square roots are needed. With the
+///        support radius "R" not exceeding the cell size of a "MultiGrid", all interactions of a node are found in it's
+///        3^dim neighbourhood.
+/// @tparam Real The floating point type.
+template <class Real>
+class GaussianKernel
+{
+private:
+
+    static_assert(std::is_floating_point<Real>::value, "Real has to be a floating point type.");
+
+public:
+
+    /// @brief Constructor.
+    /// @param sigma The standard deviation of the Gaussian.
+    /// @param support_radius The radius, beyond which the kernel is zero.
+    /// @throws std::runtime_error If the standard deviation or the support radius is not positive.
+    GaussianKernel(Real sigma, Real support_radius);
+
+    /// @brief Returns the radius, beyond which the kernel is zero.
+    /// @return The support radius.
+    Real getSupportRadius() const;
+
+    /// @brief Evaluates the kernel.
+    /// @param r2 The squared distance.
+    /// @return The weight.
+    Real value(Real r2) const;
+
+    /// @brief Evaluates the derivative of the kernel with respect to the squared distance. The gradient with respect
+    ///        to the offset vector "x" is "2 * x * derivative(|x|^2)".
+    /// @param r2 The squared distance.
+    /// @return The derivative.
+    Real derivative(Real r2) const;
+
+    /// @brief Evaluates the kernel and it's derivative for an array of squared distances.
+    /// @param r2 The squared distances.
+    /// @param values The output weights.
+    /// @param derivatives The output derivatives.
+    /// @param count The number of squared distances.
+    void evaluate(const Real* r2, Real* values, Real* derivatives, size_t count) const;
+
+private:
+
+    Real support_radius_;  ///< The radius, beyond which the kernel is zero
+    Real support_radius2_; ///< The squared support radius
+    Real inv_two_sigma2_;  ///< 1 / (2 * sigma^2)
+    Real offset_;          ///< The value of the Gaussian at the support radius
+    Real scale_;           ///< Normalizes the shifted Gaussian to be one at zero distance
+};
+
+/// @brief The "GaussianKernel" tabulated over the squared distance, evaluated by linear interpolation. The batch
+///        evaluation is written as independent table lookups, which the compiler vectorizes into gathers.
+/// @tparam Real The floating point type.
+template <class Real>
+class TabulatedGaussianKernel
+{
+public:
+
+    /// @brief Constructor.
+    /// @param kernel The tabulated kernel.
+    /// @param tolerance The maximal absolute error of the weights, and of the derivatives relative to their largest
+    ///                  magnitude. Determines the size of the table.
+    /// @throws std::runtime_error If the tolerance is not positive, or would require more, than "kMaxTableSize"
+    ///                            entries.
+    TabulatedGaussianKernel(const GaussianKernel<Real>& kernel, Real tolerance);
+
+    /// @brief Returns the radius, beyond which the kernel is zero.
+    /// @return The support radius.
+    Real getSupportRadius() const;
+
+    /// @brief Returns the number of intervals of the table.
+    /// @return The number of intervals.
+    size_t getTableSize() const;
+
+    /// @copydoc GaussianKernel::value
+    Real value(Real r2) const;
+
+    /// @copydoc GaussianKernel::derivative
+    Real derivative(Real r2) const;
+
+    /// @copydoc GaussianKernel::evaluate
+    void evaluate(const Real* r2, Real* values, Real* derivatives, size_t count) const;
+
+    static constexpr size_t kMaxTableSize = 1 << 20; ///< The maximal number of intervals of the table
+
+private:
+
+    Real support_radius_;                ///< The radius, beyond which the kernel is zero
+    Real support_radius2_;               ///< The squared support radius
+    Real inv_step_;                      ///< The reciprocal of the squared distance between the table entries
+    std::vector<Real> values_;           ///< The weights at the table entries, and a zero past the support
+    std::vector<Real> value_steps_;      ///< The differences of the consecutive weights
+    std::vector<Real> derivatives_;      ///< The derivatives at the table entries, and a zero past the support
+    std::vector<Real> derivative_steps_; ///< The differences of the consecutive derivatives
+};
+
+/// @brief The "GaussianKernel" approximated by a polynomial of the squared distance. The polynomial interpolates the
+///        kernel in the Chebyshev nodes of the support, which is within a small factor of the minimax (best uniform)
+///        approximation of the same degree, and is evaluated with the Clenshaw recurrence.
+/// @tparam Real The floating point type.
+template <class Real>
+class PolynomialGaussianKernel
+{
+public:
+
+    /// @brief Constructor. Uses the lowest degree satisfying the tolerance.
+    /// @param kernel The approximated kernel.
+    /// @param tolerance The maximal absolute error of the weights, and of the derivatives relative to their largest
+    ///                  magnitude.
+    /// @throws std::runtime_error If the tolerance is not positive, or can not be satisfied up to "kMaxDegree".
+    PolynomialGaussianKernel(const GaussianKernel<Real>& kernel, Real tolerance);
+
+    /// @brief Returns the radius, beyond which the kernel is zero.
+    /// @return The support radius.
+    Real getSupportRadius() const;
+
+    /// @brief Returns the degree of the approximating polynomial.
+    /// @return The degree.
+    size_t getDegree() const;
+
+    /// @copydoc GaussianKernel::value
+    Real value(Real r2) const;
+
+    /// @copydoc GaussianKernel::derivative
+    Real derivative(Real r2) const;
+
+    /// @copydoc GaussianKernel::evaluate
+    void evaluate(const Real* r2, Real* values, Real* derivatives, size_t count) const;
+
+    static constexpr size_t kMaxDegree = 32; ///< The maximal degree of the approximating polynomial
+
+private:
+
+    /// @brief Fits the Chebyshev series of the given degree to the kernel.
+    /// @param kernel The approximated kernel.
+    /// @param degree The degree.
+    void fit(const GaussianKernel<Real>& kernel, size_t degree);
+
+    /// @brief Evaluates a Chebyshev series with the Clenshaw recurrence.
+    /// @param coefficients The coefficients of the series.
+    /// @param x The evaluation point in [-1, 1].
+    /// @return The value of the series.
+    static Real clenshaw(const std::vector<Real>& coefficients, Real x);
+
+    Real support_radius_;                       ///< The radius, beyond which the kernel is zero
+    Real support_radius2_;                      ///< The squared support radius
+    std::vector<Real> value_coefficients_;      ///< The Chebyshev coefficients of the kernel
+    std::vector<Real> derivative_coefficients_; ///< The Chebyshev coefficients of the kernel's derivative
+};
+
+template <class Real>
+constexpr size_t TabulatedGaussianKernel<Real>::kMaxTableSize;
+
+template <class Real>
+constexpr size_t PolynomialGaussianKernel<Real>::kMaxDegree;
+
+//======================================================================================================================
+
+template <class Real>
+GaussianKernel<Real>::GaussianKernel(Real sigma, Real support_radius)
+    : support_radius_(support_radius)
+    , support_radius2_(support_radius * support_radius)
+    , inv_two_sigma2_(Real(1) / (2 * sigma * sigma))
+{
+    if (!(sigma > 0) || !(support_radius > 0))
+    {
+        throw std::runtime_error("The standard deviation and the support radius have to be greater, than zero!");
+    }
+
+    offset_ = std::exp(-support_radius2_ * inv_two_sigma2_);
+    scale_ = Real(1) / (1 - offset_);
+}
+
+template <class Real>
+Real GaussianKernel<Real>::getSupportRadius() const
+{
+    return support_radius_;
+}
+
+template <class Real>
+Real GaussianKernel<Real>::value(Real r2) const
+{
+    return r2 < support_radius2_ ? (std::exp(-r2 * inv_two_sigma2_) - offset_) * scale_ : Real(0);
+}
+
+template <class Real>
+Real GaussianKernel<Real>::derivative(Real r2) const
+{
+    return r2 < support_radius2_ ? -std::exp(-r2 * inv_two_sigma2_) * inv_two_sigma2_ * scale_ : Real(0);
+}
+
+template <class Real>
+void GaussianKernel<Real>::evaluate(const Real* r2, Real* values, Real* derivatives, size_t count) const
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        const auto inside = r2[i] < support_radius2_;
+        const auto gaussian = std::exp(-r2[i] * inv_two_sigma2_);
+        values[i] = inside ? (gaussian - offset_) * scale_ : Real(0);
+        derivatives[i] = inside ? -gaussian * inv_two_sigma2_ * scale_ : Real(0);
+    }
+}
+
+//======================================================================================================================
+
+template <class Real>
+TabulatedGaussianKernel<Real>::TabulatedGaussianKernel(const GaussianKernel<Real>& kernel, Real tolerance)
+    : support_radius_(kernel.getSupportRadius())
+    , support_radius2_(kernel.getSupportRadius() * kernel.getSupportRadius())
+{
+    if (!(tolerance > 0))
+    {
+        throw std::runtime_error("The tolerance has to be greater, than zero!");
+    }
+
+    // The error of the linear interpolation is bounded by "step^2 / 8 * max|f''|". Relative to their magnitude at
+    // zero distance, the second derivative of the weight and of it's derivative are both bounded by the square of
+    // the derivative at zero distance.
+    const auto max_slope = std::abs(static_cast<double>(kernel.derivative(0)));
+    const auto max_step = std::sqrt(8.0 * static_cast<double>(tolerance)) / max_slope;
+    const auto table_size = std::ceil(static_cast<double>(support_radius2_) / max_step);
+    if (table_size > static_cast<double>(kMaxTableSize))
+    {
+        throw std::runtime_error("TabulatedGaussianKernel: The tolerance requires a too large table!");
+    }
+
+    const auto num_intervals = std::max<size_t>(static_cast<size_t>(table_size), 1);
+    const auto step = support_radius2_ / static_cast<Real>(num_intervals);
+    inv_step_ = Real(1) / step;
+
+    // The extra entry past the support makes the lookup beyond the support branch free
+    values_.resize(num_intervals + 1, Real(0));
+    derivatives_.resize(num_intervals + 1, Real(0));
+    for (size_t i = 0; i < num_intervals; ++i)
+    {
+        values_[i] = kernel.value(static_cast<Real>(i) * step);
+        derivatives_[i] = kernel.derivative(static_cast<Real>(i) * step);
+    }
+    // The derivative jumps to zero at the support radius, so the last interval interpolates towards it's inner limit
+    derivatives_[num_intervals] = kernel.derivative(support_radius2_ * (1 - std::numeric_limits<Real>::epsilon()));
+
+    value_steps_.resize(num_intervals + 1, Real(0));
+    derivative_steps_.resize(num_intervals + 1, Real(0));
+    for (size_t i = 0; i < num_intervals; ++i)
+    {
+        value_steps_[i] = values_[i + 1] - values_[i];
+        derivative_steps_[i] = derivatives_[i + 1] - derivatives_[i];
+    }
+    derivatives_[num_intervals] = Real(0);
+}
+
+template <class Real>
+Real TabulatedGaussianKernel<Real>::getSupportRadius() const
+{
+    return support_radius_;
+}
+
+template <class Real>
+size_t TabulatedGaussianKernel<Real>::getTableSize() const
+{
+    return value_steps_.size() - 1;
+}
+
+template <class Real>
+Real TabulatedGaussianKernel<Real>::value(Real r2) const
+{
+    Real result;
+    Real unused;
+    evaluate(&r2, &result, &unused, 1);
+    return result;
+}
+
+template <class Real>
+Real TabulatedGaussianKernel<Real>::derivative(Real r2) const
+{
+    Real unused;
+    Real result;
+    evaluate(&r2, &unused, &result, 1);
+    return result;
+}
+
+template <class Real>
+void TabulatedGaussianKernel<Real>::evaluate(const Real* r2, Real* values, Real* derivatives, size_t count) const
+{
+    const auto last = static_cast<Real>(getTableSize());
+    const auto* value_table = values_.data();
+    const auto* value_step_table = value_steps_.data();
+    const auto* derivative_table = derivatives_.data();
+    const auto* derivative_step_table = derivative_steps_.data();
+    for (size_t i = 0; i < count; ++i)
+    {
+        // Squared distances beyond the support are clamped to the zero entry past the last interval
+        const auto position = std::min(r2[i] * inv_step_, last);
+        const auto index = static_cast<size_t>(position);
+        const auto fraction = position - static_cast<Real>(index);
+        values[i] = value_table[index] + fraction * value_step_table[index];
+        derivatives[i] = derivative_table[index] + fraction * derivative_step_table[index];
+    }
+}
+
+//======================================================================================================================
+
+template <class Real>
+PolynomialGaussianKernel<Real>::PolynomialGaussianKernel(const GaussianKernel<Real>& kernel, Real tolerance)
+    : support_radius_(kernel.getSupportRadius())
+    , support_radius2_(kernel.getSupportRadius() * kernel.getSupportRadius())
+{
+    if (!(tolerance > 0))
+    {
+        throw std::runtime_error("The tolerance has to be greater, than zero!");
+    }
+
+    const size_t kNumSamples = 1024;
+    const auto max_derivative = std::abs(kernel.derivative(0));
+    for (size_t degree = 1; degree <= kMaxDegree; ++degree)
+    {
+        fit(kernel, degree);
+
+        Real max_error = 0;
+        for (size_t i = 0; i < kNumSamples; ++i)
+        {
+            const auto r2 = support_radius2_ * static_cast<Real>(i) / kNumSamples;
+            max_error = std::max(max_error, std::abs(value(r2) - kernel.value(r2)));
+            max_error = std::max(max_error, std::abs(derivative(r2) - kernel.derivative(r2)) / max_derivative);
+        }
+
+        if (max_error <= tolerance)
+        {
+            return;
+        }
+    }
+
+    throw std::runtime_error("PolynomialGaussianKernel: The tolerance can not be satisfied!");
+}
+
+template <class Real>
+Real PolynomialGaussianKernel<Real>::getSupportRadius() const
+{
+    return support_radius_;
+}
+
+template <class Real>
+size_t PolynomialGaussianKernel<Real>::getDegree() const
+{
+    return value_coefficients_.size() - 1;
+}
+
+template <class Real>
+Real PolynomialGaussianKernel<Real>::value(Real r2) const
+{
+    return r2 < support_radius2_ ? clenshaw(value_coefficients_, 2 * r2 / support_radius2_ - 1) : Real(0);
+}
+
+template <class Real>
+Real PolynomialGaussianKernel<Real>::derivative(Real r2) const
+{
+    return r2 < support_radius2_ ? clenshaw(derivative_coefficients_, 2 * r2 / support_radius2_ - 1) : Real(0);
+}
+
+template <class Real>
+void PolynomialGaussianKernel<Real>::evaluate(const Real* r2, Real* values, Real* derivatives, size_t count) const
+{
+    // The recurrence runs over blocks of distances in lockstep, so the innermost loops vectorize over the distances
+    const size_t kBlockSize = 64;
+    Real x[kBlockSize];
+    Real value_b1[kBlockSize];
+    Real value_b2[kBlockSize];
+    Real derivative_b1[kBlockSize];
+    Real derivative_b2[kBlockSize];
+
+    const auto inv_support_radius2 = Real(1) / support_radius2_;
+    for (size_t block_begin = 0; block_begin < count; block_begin += kBlockSize)
+    {
+        const auto block_size = std::min(kBlockSize, count - block_begin);
+        for (size_t i = 0; i < block_size; ++i)
+        {
+            x[i] = std::min(2 * r2[block_begin + i] * inv_support_radius2 - 1, Real(1));
+            value_b1[i] = value_b2[i] = derivative_b1[i] = derivative_b2[i] = 0;
+        }
+
+        for (size_t k = value_coefficients_.size() - 1; k > 0; --k)
+        {
+            const auto coefficient = value_coefficients_[k];
+            for (size_t i = 0; i < block_size; ++i)
+            {
+                const auto b0 = coefficient + 2 * x[i] * value_b1[i] - value_b2[i];
+                value_b2[i] = value_b1[i];
+                value_b1[i] = b0;
+            }
+        }
+
+        for (size_t k = derivative_coefficients_.size() - 1; k > 0; --k)
+        {
+            const auto coefficient = derivative_coefficients_[k];
+            for (size_t i = 0; i < block_size; ++i)
+            {
+                const auto b0 = coefficient + 2 * x[i] * derivative_b1[i] - derivative_b2[i];
+                derivative_b2[i] = derivative_b1[i];
+                derivative_b1[i] = b0;
+            }
+        }
+
+        for (size_t i = 0; i < block_size; ++i)
+        {
+            const auto inside = r2[block_begin + i] < support_radius2_;
+            const auto value = value_coefficients_[0] + x[i] * value_b1[i] - value_b2[i];
+            const auto derivative = derivative_coefficients_[0] + x[i] * derivative_b1[i] - derivative_b2[i];
+            values[block_begin + i] = inside ? value : Real(0);
+            derivatives[block_begin + i] = inside ? derivative : Real(0);
+        }
+    }
+}
+
+template <class Real>
+void PolynomialGaussianKernel<Real>::fit(const GaussianKernel<Real>& kernel, size_t degree)
+{
+    // Interpolation in the Chebyshev nodes of the first kind, computed in double precision
+    const auto num_nodes = degree + 1;
+    const auto pi = std::acos(-1.0);
+    std::vector<double> samples(num_nodes);
+    for (size_t j = 0; j < num_nodes; ++j)
+    {
+        const auto x = std::cos(pi * (j + 0.5) / num_nodes);
+        samples[j] = static_cast<double>(kernel.value(static_cast<Real>((x + 1) / 2 * support_radius2_)));
+    }
+
+    std::vector<double> coefficients(num_nodes);
+    for (size_t k = 0; k < num_nodes; ++k)
+    {
+        double sum = 0;
+        for (size_t j = 0; j < num_nodes; ++j)
+        {
+            sum += samples[j] * std::cos(pi * k * (j + 0.5) / num_nodes);
+        }
+        coefficients[k] = sum * 2 / num_nodes;
+    }
+    coefficients[0] /= 2;
+
+    // The derivative of a Chebyshev series: c'[k - 1] = c'[k + 1] + 2 * k * c[k], scaled by dx / dr2
+    std::vector<double> derivative_coefficients(num_nodes + 1, 0.0);
+    for (size_t k = degree; k > 0; --k)
+    {
+        derivative_coefficients[k - 1] = derivative_coefficients[k + 1] + 2.0 * k * coefficients[k];
+    }
+    derivative_coefficients[0] /= 2;
+    derivative_coefficients.resize(std::max<size_t>(degree, 1));
+
+    const auto dx_dr2 = 2.0 / static_cast<double>(support_radius2_);
+    value_coefficients_.assign(coefficients.begin(), coefficients.end());
+    derivative_coefficients_.resize(derivative_coefficients.size());
+    for (size_t k = 0; k < derivative_coefficients.size(); ++k)
+    {
+        derivative_coefficients_[k] = static_cast<Real>(derivative_coefficients[k] * dx_dr2);
+    }
+}
+
+template <class Real>
+Real PolynomialGaussianKernel<Real>::clenshaw(const std::vector<Real>& coefficients, Real x)
+{
+    Real b1 = 0;
+    Real b2 = 0;
+    for (size_t k = coefficients.size() - 1; k > 0; --k)
+    {
+        const auto b0 = coefficients[k] + 2 * x * b1 - b2;
+        b2 = b1;
+        b1 = b0;
+    }
+    return coefficients[0] + x * b1 - b2;
+}
+
+} // end namespace dire
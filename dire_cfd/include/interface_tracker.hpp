@@ -0,0 +1,282 @@
+///
+/// @copyrightblock
+///
+///   NPOSL-3.0 License
+///
+///   Copyright(c) 2021 Mtys Lrnt-Nyeste
+///
+///   Licensed under the Non-Profit Open Software License, version 3.0 (the "License"); you may not use this file except
+///   in compliance with the License. You may obtain a copy of the License at:
+///
+///   https://opensource.org/licenses/NPOSL-3.0
+///
+///   Unless required by applicable law or agreed to in writing, software distributed under the License is distributed
+///   on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for
+///   the specific language governing permissionsand limitations under the License.
+///
+/// @endcopyrightblock
+///
+
+#pragma once
+
+#include "multi_grid.hpp"
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace dire {
+
+/// @brief Tracks the cells of a "MultiGrid" at phase interfaces and free surfaces: the occupied cells that contain
+///        nodes of multiple phases, or have a neighbour with a different set of phases (including empty neighbours).
+///        The phase flags are recomputed only for the cells occupied now or at the last update, using the grid's
+///        occupancy list, and the interface band is updated only around the cells whose flags changed. An update
+///        thus costs O(occupied cells + changed cells * 3^dim) instead of O(volume), and interface kernels run over a
+///        cell list proportional to the interface area.
+/// @tparam dim The dimensionality of the grid.
+/// @tparam Data The type of the stored data.
+/// @tparam Index The unsigned integer type of the cell ids and data ids of the tracked grids.
+template <size_t dim, class Data, class Index = size_t>
+class InterfaceTracker
+{
+public:
+
+    using Grid = MultiGrid<dim, Data, Index>;
+    using GridSize = typename Grid::GridSize;
+    using CellId = typename Grid::CellId;
+    using PhaseFlags = uint8_t; ///< The set of phases present in a cell, bit "i" standing for phase "i"
+
+    static constexpr size_t kMaxNumPhases = 8; ///< The maximal number of distinguished phases
+
+    /// @brief Constructor.
+    /// @param grid_size The size of the tracked grids.
+    /// @throws std::runtime_error If any of the grid sizes is zero.
+    explicit InterfaceTracker(const GridSize& grid_size);
+
+    /// @brief Recomputes the phase flags of the cells occupied now or at the last update from a compressed grid, and
+    ///        updates the interface band around the cells whose flags changed since the last update. The tracker is
+    ///        left unchanged, if an exception is thrown.
+    /// @param grid The grid. Must have the size given at construction.
+    /// @param phase_of Called as "phase_of(data)", returning the phase of a data in [0, kMaxNumPhases).
+    /// @throws std::runtime_error If the grid is not compressed, or it's size differs from the tracked size.
+    /// @throws std::out_of_range If an invalid phase is returned.
+    template <class PhaseOf>
+    void update(const Grid& grid, PhaseOf&& phase_of);
+
+    /// @brief Returns the phases present in a cell, as of the last update.
+    /// @param cell_id The id of the cell.
+    /// @return The phase flags.
+    /// @throws std::out_of_range If an invalid cell id is provided.
+    PhaseFlags getPhaseFlags(const CellId& cell_id) const;
+
+    /// @brief Returns whether a cell is in the interface band.
+    /// @param cell_id The id of the cell.
+    /// @return Whether the cell is in the band.
+    /// @throws std::out_of_range If an invalid cell id is provided.
+    bool isInterfaceCell(const CellId& cell_id) const;
+
+    /// @brief Returns the number of cells in the interface band.
+    /// @return The number of cells.
+    size_t getNumInterfaceCells() const;
+
+    /// @brief Visits the cells of the interface band in an unspecified order. Used for running interface kernels
+    ///        (e.g. surface tension) only where they are needed.
+    /// @param function Called with the id of each cell in the band.
+    template <class Function>
+    void forEachInterfaceCell(Function&& function) const;
+
+private:
+
+    /// @brief Decides whether a cell belongs to the interface band, and adds or removes it accordingly.
+    /// @param grid The grid, whose neighbourhoods are enumerated.
+    /// @param cell_id The id of the cell.
+    void classify(const Grid& grid, const CellId& cell_id);
+
+    /// @brief Checks a cell id, and linearizes it.
+    /// @param cell_id The cell id.
+    /// @return The storage id.
+    /// @throws std::out_of_range If an invalid cell id is provided.
+    size_t toStorageId(const CellId& cell_id) const;
+
+    static constexpr size_t kNotInBand = std::numeric_limits<size_t>::max(); ///< Band index of cells outside the band
+
+    GridSize grid_size_;                                   ///< The size of the tracked grids
+    std::vector<PhaseFlags> phase_flags_;                  ///< The phases present in each cell
+    std::vector<CellId> occupied_cells_;                   ///< The cells with any phase, as of the last update
+    std::vector<std::pair<CellId, PhaseFlags>> new_flags_; ///< Buffer for the flags of the occupied cells
+    std::vector<CellId> band_;                             ///< The cells in the band
+    std::vector<size_t> band_index_;                       ///< The position of each cell in the band, or "kNotInBand"
+    std::vector<CellId> changed_cells_;                    ///< Buffer for the cells, whose flags changed
+};
+
+template <size_t dim, class Data, class Index>
+constexpr size_t InterfaceTracker<dim, Data, Index>::kMaxNumPhases;
+
+template <size_t dim, class Data, class Index>
+constexpr size_t InterfaceTracker<dim, Data, Index>::kNotInBand;
+
+//======================================================================================================================
+
+template <size_t dim, class Data, class Index>
+InterfaceTracker<dim, Data, Index>::InterfaceTracker(const GridSize& grid_size)
+    : grid_size_(grid_size)
+{
+    for (size_t i = 0; i < dim; ++i)
+    {
+        if (grid_size_[i] == 0)
+        {
+            throw std::runtime_error("All grid sizes have to be greater, than zero!");
+        }
+    }
+
+    const auto num_cells = std::accumulate(grid_size.begin(), grid_size.end(), size_t(1), std::multiplies<size_t>());
+    phase_flags_.resize(num_cells, 0);
+    band_index_.resize(num_cells, kNotInBand);
+}
+
+template <size_t dim, class Data, class Index>
+template <class PhaseOf>
+void InterfaceTracker<dim, Data, Index>::update(const Grid& grid, PhaseOf&& phase_of)
+{
+    if (grid.getGridSize() != grid_size_)
+    {
+        throw std::runtime_error("InterfaceTracker::update(): The size of the grid differs from the tracked size!");
+    }
+
+    // Computing all flags before changing anything, so a throwing phase leaves the tracker intact
+    new_flags_.clear();
+    grid.forEachOccupiedCell([&](const CellId& cell_id, const typename Grid::DataBounds& bounds)
+    {
+        PhaseFlags flags = 0;
+        for (auto it = bounds.begin; it != bounds.end; ++it)
+        {
+            const auto phase = static_cast<size_t>(phase_of(*it));
+            if (phase >= kMaxNumPhases)
+            {
+                throw std::out_of_range("InterfaceTracker::update(): Invalid phase!");
+            }
+            flags |= static_cast<PhaseFlags>(1u << phase);
+        }
+        new_flags_.emplace_back(cell_id, flags);
+    });
+
+    // Only the previously occupied cells can become empty, and only the occupied cells can have phases
+    changed_cells_.clear();
+    for (const auto& cell_id : occupied_cells_)
+    {
+        if (!grid.isOccupied(cell_id))
+        {
+            phase_flags_[toStorageId(cell_id)] = 0;
+            changed_cells_.push_back(cell_id);
+        }
+    }
+
+    occupied_cells_.clear();
+    for (const auto& cell_flags : new_flags_)
+    {
+        auto& flags = phase_flags_[toStorageId(cell_flags.first)];
+        if (flags != cell_flags.second)
+        {
+            flags = cell_flags.second;
+            changed_cells_.push_back(cell_flags.first);
+        }
+        occupied_cells_.push_back(cell_flags.first);
+    }
+
+    // Only the changed cells and their neighbours may enter or leave the band
+    for (const auto& changed_id : changed_cells_)
+    {
+        grid.enumerateNeighbourhood(changed_id, [&](const CellId& neighbour_id, const typename Grid::DataBounds&)
+        {
+            classify(grid, neighbour_id);
+        });
+    }
+}
+
+template <size_t dim, class Data, class Index>
+typename InterfaceTracker<dim, Data, Index>::PhaseFlags InterfaceTracker<dim, Data, Index>::getPhaseFlags(
+    const CellId& cell_id) const
+{
+    return phase_flags_[toStorageId(cell_id)];
+}
+
+template <size_t dim, class Data, class Index>
+bool InterfaceTracker<dim, Data, Index>::isInterfaceCell(const CellId& cell_id) const
+{
+    return band_index_[toStorageId(cell_id)] != kNotInBand;
+}
+
+template <size_t dim, class Data, class Index>
+size_t InterfaceTracker<dim, Data, Index>::getNumInterfaceCells() const
+{
+    return band_.size();
+}
+
+template <size_t dim, class Data, class Index>
+template <class Function>
+void InterfaceTracker<dim, Data, Index>::forEachInterfaceCell(Function&& function) const
+{
+    for (const auto& cell_id : band_)
+    {
+        function(cell_id);
+    }
+}
+
+template <size_t dim, class Data, class Index>
+void InterfaceTracker<dim, Data, Index>::classify(const Grid& grid, const CellId& cell_id)
+{
+    const auto storage_id = toStorageId(cell_id);
+    const auto flags = phase_flags_[storage_id];
+
+    bool in_band = false;
+    if (flags != 0)
+    {
+        // Multiple phases in the cell, or a neighbour with different phases (an empty one is a free surface)
+        in_band = (flags & (flags - 1)) != 0;
+        grid.enumerateNeighbourhood(cell_id, [&](const CellId& neighbour_id, const typename Grid::DataBounds&)
+        {
+            in_band = in_band || phase_flags_[toStorageId(neighbour_id)] != flags;
+        });
+    }
+
+    auto& band_index = band_index_[storage_id];
+    if (in_band && band_index == kNotInBand)
+    {
+        band_index = band_.size();
+        band_.push_back(cell_id);
+    }
+    else if (!in_band && band_index != kNotInBand)
+    {
+        // Swap-remove, keeping the band contiguous
+        const auto moved_id = band_.back();
+        band_[band_index] = moved_id;
+        band_index_[toStorageId(moved_id)] = band_index;
+        band_.pop_back();
+        band_index = kNotInBand;
+    }
+}
+
+template <size_t dim, class Data, class Index>
+size_t InterfaceTracker<dim, Data, Index>::toStorageId(const CellId& cell_id) const
+{
+    size_t storage_id = 0;
+    size_t mult = 1;
+    for (size_t i = 0; i < dim; ++i)
+    {
+        if (cell_id[i] >= grid_size_[i])
+        {
+            throw std::out_of_range("InterfaceTracker: Invalid cell id!");
+        }
+
+        storage_id += cell_id[i] * mult;
+        mult *= grid_size_[i];
+    }
+    return storage_id;
+}
+
+} // end namespace dire
@@ -19,31 +19,316 @@
 
 #pragma once
 
+#include "thread_pool.hpp"
+
+#include <algorithm>
 #include <array>
+#include <cmath>
+#include <cstdint>
+#include <future>
+#include <limits>
+#include <memory>
 #include <vector>
 #include <numeric>
 #include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DIRE_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+#define DIRE_AVX2
+#include <immintrin.h>
+#endif
 
 namespace dire {
 
+namespace detail {
+
+constexpr size_t kCacheLineSize = 64; ///< The assumed size of a cache line in bytes
+
+/// @brief Hints the processor to load the cache line of the given address into all levels of the cache.
+/// @param address The address.
+inline void prefetch(const void* address)
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    _mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+#elif defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(address);
+#else
+    (void)address;
+#endif
+}
+
+/// @brief An allocator default-initializing the elements of a container, instead of value-initializing them, so
+///        resizing a vector of trivial elements leaves them uninitialized, rather than zeroing them in an extra pass.
+/// @tparam Value The type of the elements.
+template <class Value>
+class DefaultInitAllocator : public std::allocator<Value>
+{
+public:
+
+    template <class Other>
+    struct rebind
+    {
+        using other = DefaultInitAllocator<Other>;
+    };
+
+    using std::allocator<Value>::allocator;
+
+    template <class Other>
+    void construct(Other* element)
+    {
+        ::new (static_cast<void*>(element)) Other;
+    }
+
+    template <class Other, class... Args>
+    void construct(Other* element, Args&&... args)
+    {
+        ::new (static_cast<void*>(element)) Other(std::forward<Args>(args)...);
+    }
+};
+
+/// @brief Computes the exclusive prefix sums of an array.
+/// @param values The values.
+/// @param sums Receives the sum of the values before each value. May be the values themselves.
+/// @param size The number of values.
+/// @return The sum of all values.
+template <class Value>
+Value exclusiveScan(const Value* values, Value* sums, size_t size)
+{
+    Value sum = 0;
+    for (size_t i = 0; i < size; ++i)
+    {
+        const auto value = values[i];
+        sums[i] = sum;
+        sum += value;
+    }
+    return sum;
+}
+
+#if defined(DIRE_SSE2)
+/// @brief Computes the exclusive prefix sums of an array of 32 bit values, 4 or 8 values at a time. The prefix sums of
+///        each vector are computed in registers in log2 steps of shifts and additions, and the running total is
+///        carried in a register, instead of through memory.
+/// @param values The values.
+/// @param sums Receives the sum of the values before each value. May be the values themselves.
+/// @param size The number of values.
+/// @return The sum of all values.
+inline uint32_t exclusiveScan(const uint32_t* values, uint32_t* sums, size_t size)
+{
+    size_t i = 0;
+    uint32_t sum = 0;
+
+#if defined(DIRE_AVX2)
+    auto carry = _mm256_setzero_si256();
+    for (; i + 8 <= size; i += 8)
+    {
+        const auto vector = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+
+        // Inclusive sums inside the 128 bit lanes, then the total of the low lane added to the high lane
+        auto inclusive = _mm256_add_epi32(vector, _mm256_slli_si256(vector, 4));
+        inclusive = _mm256_add_epi32(inclusive, _mm256_slli_si256(inclusive, 8));
+        const auto low_total = _mm256_shuffle_epi32(inclusive, 0xFF);
+        inclusive = _mm256_add_epi32(inclusive, _mm256_permute2x128_si256(low_total, low_total, 0x08));
+
+        const auto exclusive = _mm256_add_epi32(_mm256_sub_epi32(inclusive, vector), carry);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(sums + i), exclusive);
+        carry = _mm256_add_epi32(carry, _mm256_permutevar8x32_epi32(inclusive, _mm256_set1_epi32(7)));
+    }
+    sum = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm256_castsi256_si128(carry)));
+#endif
+
+    auto carry_128 = _mm_set1_epi32(static_cast<int>(sum));
+    for (; i + 4 <= size; i += 4)
+    {
+        const auto vector = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+        auto inclusive = _mm_add_epi32(vector, _mm_slli_si128(vector, 4));
+        inclusive = _mm_add_epi32(inclusive, _mm_slli_si128(inclusive, 8));
+
+        const auto exclusive = _mm_add_epi32(_mm_sub_epi32(inclusive, vector), carry_128);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(sums + i), exclusive);
+        carry_128 = _mm_add_epi32(carry_128, _mm_shuffle_epi32(inclusive, 0xFF));
+    }
+    sum = static_cast<uint32_t>(_mm_cvtsi128_si32(carry_128));
+
+    for (; i < size; ++i)
+    {
+        const auto value = values[i];
+        sums[i] = sum;
+        sum += value;
+    }
+    return sum;
+}
+
+/// @brief Computes the exclusive prefix sums of an array of 64 bit values, 2 or 4 values at a time, like the 32 bit
+///        version. Used by the default "size_t" index type.
+/// @param values The values.
+/// @param sums Receives the sum of the values before each value. May be the values themselves.
+/// @param size The number of values.
+/// @return The sum of all values.
+inline uint64_t exclusiveScan(const uint64_t* values, uint64_t* sums, size_t size)
+{
+    size_t i = 0;
+    uint64_t sum = 0;
+
+#if defined(DIRE_AVX2)
+    auto carry = _mm256_setzero_si256();
+    for (; i + 4 <= size; i += 4)
+    {
+        const auto vector = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+
+        // Inclusive sums inside the 128 bit lanes, then the total of the low lane added to the high lane
+        auto inclusive = _mm256_add_epi64(vector, _mm256_slli_si256(vector, 8));
+        const auto low_total = _mm256_shuffle_epi32(inclusive, 0xEE);
+        inclusive = _mm256_add_epi64(inclusive, _mm256_permute2x128_si256(low_total, low_total, 0x08));
+
+        const auto exclusive = _mm256_add_epi64(_mm256_sub_epi64(inclusive, vector), carry);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(sums + i), exclusive);
+        carry = _mm256_add_epi64(carry, _mm256_permute4x64_epi64(inclusive, 0xFF));
+    }
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(&sum), _mm256_castsi256_si128(carry));
+#endif
+
+    auto carry_128 = _mm_set1_epi64x(static_cast<long long>(sum));
+    for (; i + 2 <= size; i += 2)
+    {
+        const auto vector = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+        const auto inclusive = _mm_add_epi64(vector, _mm_slli_si128(vector, 8));
+
+        const auto exclusive = _mm_add_epi64(_mm_sub_epi64(inclusive, vector), carry_128);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(sums + i), exclusive);
+        carry_128 = _mm_add_epi64(carry_128, _mm_shuffle_epi32(inclusive, 0xEE));
+    }
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(&sum), carry_128);
+
+    for (; i < size; ++i)
+    {
+        const auto value = values[i];
+        sums[i] = sum;
+        sum += value;
+    }
+    return sum;
+}
+#endif
+
+/// @brief Computes a non-negative integer power.
+/// @param base The base.
+/// @param exponent The exponent.
+/// @return The power.
+constexpr size_t power(size_t base, size_t exponent)
+{
+    return exponent == 0 ? 1 : base * power(base, exponent - 1);
+}
+
+/// @brief Computes the number of cells in a 3^dim neighbourhood.
+/// @param dim The dimensionality.
+/// @return The number of cells.
+constexpr size_t neighbourhoodSize(size_t dim)
+{
+    return dim == 0 ? 1 : 3 * neighbourhoodSize(dim - 1);
+}
+
+} // end namespace detail
+
 /// @brief A grid of the given dimensionality, that can hold multiple elements in each cell.
-template <size_t dim, class Data>
+/// @tparam Index The unsigned integer type of the cell ids, and of the per-cell counts and data ids. A 32 bit type
+///               halves the per-cell metadata of grids with fewer, than 2^32 cells and data.
+template <size_t dim, class Data, class Index = size_t>
 class MultiGrid
 {
 private:
 
     static_assert(dim > 0, "The dimensionality must be greater, than zero!");
     static_assert(std::is_default_constructible<Data>::value, "Data has to be default constructible.");
+    static_assert(std::is_integral<Index>::value && std::is_unsigned<Index>::value,
+                  "Index has to be an unsigned integral type.");
 
 public:
 
-    using GridSize = std::array<size_t, dim>;
-    using CellId = std::array<size_t, dim>;
+    using GridSize = std::array<Index, dim>;
+    using CellId = std::array<Index, dim>;
+
+    /// @brief The container of the stored data. Resizing it default-initializes the data, so trivial data is not
+    ///        zeroed, before being overwritten by the compression.
+    using DataVector = std::vector<Data, detail::DefaultInitAllocator<Data>>;
 
     struct DataBounds
     {
-        typename std::vector<Data>::const_iterator begin;
-        typename std::vector<Data>::const_iterator end;
+        typename DataVector::const_iterator begin;
+        typename DataVector::const_iterator end;
+    };
+
+    struct DataIdBounds
+    {
+        Index begin; ///< The id of the first data in the compressed order
+        Index end;   ///< The id past the last data in the compressed order
+    };
+
+    /// @brief The way "compress()" writes the data to their compressed positions.
+    enum class ScatterStrategy
+    {
+        kDirect,   ///< Each data is written directly to it's position
+        kBuffered, ///< The data is staged per bucket of cells, and written in batches (software write-combining)
+        kAuto      ///< Buffered for data smaller, than a cache line, once the data exceeds the last level cache
+    };
+
+    /// @brief Emits data into the binning buffer of another grid. Used by "advance()".
+    class Emitter
+    {
+    public:
+        explicit Emitter(MultiGrid& target) : target_(target) {}
+
+        /// @brief Adds a data to the given cell of the target grid.
+        /// @param cell_id The id of the cell.
+        /// @param data The data.
+        /// @throws std::out_of_range If an invalid cell id is provided.
+        void operator()(const CellId& cell_id, Data&& data) { target_.add(cell_id, std::move(data)); }
+
+    private:
+        MultiGrid& target_; ///< The grid receiving the emitted data
+    };
+
+    /// @brief A box of cells of a grid in a compact compressed format of it's own, built by "compressRegion()".
+    class Region
+    {
+    public:
+
+        /// @brief Enumerates all data in the given cell of the region.
+        /// @param cell_id The id of the cell in the grid.
+        /// @return The enumerated data represented by it's begin and end iterators.
+        /// @throws std::out_of_range If the cell is outside of the region.
+        DataBounds enumerateData(const CellId& cell_id) const;
+
+        /// @brief Returns the smallest cell id of the region.
+        /// @return The cell id.
+        const CellId& getBegin() const { return begin_; }
+
+        /// @brief Returns the cell id past the largest cell id of the region along each dimension.
+        /// @return The cell id.
+        const CellId& getEnd() const { return end_; }
+
+        /// @brief Returns the number of data in the region.
+        /// @return The number of data.
+        size_t getNumData() const { return data_.size(); }
+
+    private:
+
+        friend class MultiGrid;
+
+        CellId begin_{};                             ///< The smallest cell id of the region
+        CellId end_{};                               ///< The cell id past the largest cell id along each dimension
+        DataVector data_;                            ///< The data of the region in a compressed format
+        std::vector<Index> first_data_id_per_cell_;  ///< The id of the first data of each cell, and the data count
+        std::vector<Index> local_ids_buff_;          ///< Buffer for the raw and local cell ids of the data in the box
     };
 
     /// @brief Constructor.
@@ -51,7 +336,8 @@ public:
     /// @param buff_size The maximum number of data that can be stored in the buffer. If more data is supplied, than
     ///                  this amount, the underlying "std::vector" containing the datas is resized, caused by it's
     ///                  "push_back" function.
-    /// @throws std::runtime_error If any of the grid sizes is zero.
+    /// @throws std::runtime_error If any of the grid sizes is zero, or the number of cells exceeds the range of
+    ///                            "Index".
     MultiGrid(GridSize grid_size, size_t buff_size = 0);
 
     /// @brief Adds a data to the given cell of the grid. Makes the grid uncompressed.
@@ -63,9 +349,46 @@ public:
     /// @brief Clears all buffered data from the grid. Makes the grid uncompressed.
     void clear();
 
+    /// @brief Reserves storage for the given number of data, like the "buff_size" of the constructor.
+    /// @param buff_size The number of data, that can be stored without reallocation.
+    void reserve(size_t buff_size);
+
     /// @brief Converts the grid into a compressed format.
+    /// @throws std::runtime_error If the number of data exceeds the range of "Index".
     void compress();
 
+    /// @brief Converts the grid into a compressed format, partitioning the data of each cell by their node types (e.g.
+    ///        fluid, wall and tracer nodes), so "enumerateData(cell_id, node_type)" returns the data of a single type,
+    ///        and type specialized kernels need no branching per data. The data of a cell follow each other in
+    ///        ascending order of their node types, and in the order of their addition within each type. The grid is
+    ///        compressed again, even if it is already compressed.
+    /// @param num_node_types The number of node types in [1, kMaxNumNodeTypes].
+    /// @param node_type_of Called as "node_type_of(data)" for each data, returning it's node type in
+    ///                     [0, num_node_types).
+    /// @throws std::runtime_error If the number of data exceeds the range of "Index", or the number of node types is
+    ///                            invalid.
+    /// @throws std::out_of_range If a node type is invalid. The grid is left uncompressed.
+    template <class NodeTypeOf>
+    void compress(size_t num_node_types, NodeTypeOf&& node_type_of);
+
+    /// @brief Converts the grid into a compressed format on one of the worker threads of the given pool. The grid
+    ///        must not be accessed by the caller until the returned future is ready. Coroutines can achieve the same
+    ///        by "co_await pool.schedule();" before calling "compress()".
+    /// @param pool The thread pool executing the compression.
+    /// @return The future signaling the end of the compression.
+    std::future<void> compressAsync(ThreadPool& pool);
+
+    /// @brief Converts only a box of cells into a compressed format, stored in a separate region, leaving the grid
+    ///        untouched. Used for localized work (e.g. around a probe, or in a refinement window). If the grid is
+    ///        compressed, the cost is proportional to the cells and data in the box. Otherwise the buffered data is
+    ///        filtered once, and only the data in the box is written.
+    /// @param begin The smallest cell id of the box.
+    /// @param end The cell id past the largest cell id of the box along each dimension.
+    /// @param region The region receiving the box. It's storage is reused.
+    /// @throws std::runtime_error If the grid is not compressed, and the number of data exceeds the range of "Index".
+    /// @throws std::out_of_range If the box is empty, or exceeds the grid.
+    void compressRegion(const CellId& begin, const CellId& end, Region& region) const;
+
     /// @brief Enumerates all data in the given cell. The grid has to be compressed.
     /// @param cell_id The id of the cell.
     /// @return The enumerated data represented by it's begin and end iterators.
@@ -73,6 +396,231 @@ public:
     /// @throws std::out_of_range If an invalid cell id is provided.
     DataBounds enumerateData(const CellId& cell_id) const;
 
+    /// @brief Enumerates the ids of all data in the given cell, i.e. their positions in the compressed order. Used for
+    ///        indexing arrays reordered by "reorder()". The grid has to be compressed.
+    /// @param cell_id The id of the cell.
+    /// @return The range of ids.
+    /// @throws std::runtime_error If the grid is not compressed, or the permutation was not recorded.
+    /// @throws std::out_of_range If an invalid cell id is provided.
+    DataIdBounds enumerateDataIds(const CellId& cell_id) const;
+
+    /// @brief Enumerates the data of a node type in the given cell. The grid has to be compressed by node types.
+    /// @param cell_id The id of the cell.
+    /// @param node_type The node type.
+    /// @return The enumerated data represented by it's begin and end iterators.
+    /// @throws std::runtime_error If the grid is not compressed by node types.
+    /// @throws std::out_of_range If an invalid cell id or node type is provided.
+    DataBounds enumerateData(const CellId& cell_id, size_t node_type) const;
+
+    /// @brief Enumerates the ids of the data of a node type in the given cell. The grid has to be compressed by node
+    ///        types.
+    /// @param cell_id The id of the cell.
+    /// @param node_type The node type.
+    /// @return The range of ids.
+    /// @throws std::runtime_error If the grid is not compressed by node types, or the permutation was not recorded.
+    /// @throws std::out_of_range If an invalid cell id or node type is provided.
+    DataIdBounds enumerateDataIds(const CellId& cell_id, size_t node_type) const;
+
+    /// @brief Returns the number of node types, by which the data of the cells are partitioned.
+    /// @return The number of node types, or zero, if the grid is not compressed by node types.
+    size_t getNumNodeTypes() const;
+
+    /// @brief Reorders an array parallel to the added data (the i-th value belonging to the i-th added data) into the
+    ///        compressed order, using the permutation of the last compression. Lets optional per-data quantities be
+    ///        stored outside of "Data", and be reordered only when they are used. The grid has to be compressed, with
+    ///        the permutation recorded (see "setRecordPermutation()").
+    /// @param raw_values The values in the order of addition.
+    /// @param values The values in the compressed order.
+    /// @throws std::runtime_error If the grid is not compressed, the permutation was not recorded, or the number of
+    ///                            values differs from the number of data.
+    template <class Value>
+    void reorder(const std::vector<Value>& raw_values, std::vector<Value>& values) const;
+
+    /// @brief Sets whether the compressions record their permutation, the id of the added data each compressed data
+    ///        came from, as needed by "reorder()" and "enumerateDataIds()". Off by default, as it writes an additional
+    ///        index per data during each compression. Takes effect with the next compression; switching it off
+    ///        releases the recorded permutation.
+    /// @param record_permutation Whether the permutation is recorded.
+    void setRecordPermutation(bool record_permutation);
+
+    /// @brief Returns whether the compressions record their permutation.
+    /// @return Whether the permutation is recorded.
+    bool isRecordingPermutation() const;
+
+    /// @brief Returns the number of cells there are in the grid along each dimension.
+    /// @return The grid size.
+    const GridSize& getGridSize() const;
+
+    /// @brief Returns the number of data added to the grid since the last clearing.
+    /// @return The number of data.
+    size_t getNumData() const;
+
+    /// @brief Returns whether the grid is compressed.
+    /// @return Whether the grid is compressed.
+    bool isCompressed() const;
+
+    /// @brief Returns the compressed data: the data of each cell stored contiguously, the cells following each other
+    ///        in storage order. Lets host codes access the data in place. The grid has to be compressed. The returned
+    ///        array is valid until the grid is modified.
+    /// @return The compressed data.
+    /// @throws std::runtime_error If the grid is not compressed.
+    const DataVector& getCompressedData() const;
+
+    /// @brief Returns the number of data stored in each cell, indexed by the storage ids of the cells (axis 0 being
+    ///        the fastest varying). The grid has to be compressed.
+    /// @return The number of data per cell.
+    /// @throws std::runtime_error If the grid is not compressed.
+    const std::vector<Index>& getNumDataPerCell() const;
+
+    /// @brief Returns the id of the first data of each cell in the compressed data, indexed by the storage ids of the
+    ///        cells. The grid has to be compressed.
+    /// @return The first data id per cell.
+    /// @throws std::runtime_error If the grid is not compressed.
+    const std::vector<Index>& getFirstDataIdPerCell() const;
+
+    /// @brief Builds the summed-area table of the number of data per cell, so "countDataInBox()" counts the data of
+    ///        any box of cells in O(2^dim) time (e.g. for load balancing or refinement decisions). The table is scanned
+    ///        along each axis in parallel, and is dropped by the next compression. The grid has to be compressed.
+    /// @param pool The thread pool scanning the table.
+    /// @throws std::runtime_error If the grid is not compressed.
+    void buildOccupancyTable(ThreadPool& pool);
+
+    /// @brief Counts the data in a box of cells, using the summed-area table of "buildOccupancyTable()".
+    /// @param begin The smallest cell id of the box.
+    /// @param end The cell id past the largest cell id of the box along each dimension.
+    /// @return The number of data in the box.
+    /// @throws std::runtime_error If the occupancy table was not built since the last compression.
+    /// @throws std::out_of_range If the box exceeds the grid, or it's end precedes it's beginning.
+    size_t countDataInBox(const CellId& begin, const CellId& end) const;
+
+    /// @brief Replaces the content of the grid with the data of a finer grid, whose cells are "ratio" times smaller
+    ///        along each dimension. Each coarse cell receives the data of the fine cells it covers, so all data is
+    ///        transferred exactly once (the remap is conservative), and the compressed format is built directly from
+    ///        the fine cells' ranges without linearizing the individual data. The grid becomes compressed.
+    /// @param fine The fine grid. It has to be compressed.
+    /// @param ratio The ratio of the cell sizes along each dimension.
+    /// @param pool The thread pool processing the coarse cells.
+    /// @throws std::runtime_error If the fine grid is not compressed, it is this grid, or the grid sizes do not match
+    ///                            the ratio.
+    void coarsen(const MultiGrid& fine, const GridSize& ratio, ThreadPool& pool);
+
+    /// @brief Replaces the content of the grid with the data of a coarser grid, whose cells are "ratio" times larger
+    ///        along each dimension. The data of each coarse cell is distributed among the fine cells it covers, so all
+    ///        data is transferred exactly once (the remap is conservative). The grid becomes compressed.
+    /// @param coarse The coarse grid. It has to be compressed.
+    /// @param ratio The ratio of the cell sizes along each dimension.
+    /// @param locate Called as "locate(coarse_cell_id, data)" for each data, returning the offset of the fine cell
+    ///               receiving it, inside the block of fine cells covered by the coarse cell. Called concurrently.
+    /// @param pool The thread pool processing the coarse cells.
+    /// @throws std::runtime_error If the coarse grid is not compressed, it is this grid, or the grid sizes do not
+    ///                            match the ratio.
+    /// @throws std::out_of_range If an invalid offset is returned. The grid is left empty.
+    template <class Locate>
+    void refine(const MultiGrid& coarse, const GridSize& ratio, Locate&& locate, ThreadPool& pool);
+
+    /// @brief Enumerates the data of the 3^dim neighbourhood of the given cell (including the cell itself), clipped to
+    ///        the grid. The grid has to be compressed. The data of the neighbour cells is prefetched the set prefetch
+    ///        distance ahead of the enumeration.
+    /// @param cell_id The id of the cell.
+    /// @param function Called with the id of each neighbour cell and the bounds of the data stored in it.
+    /// @throws std::runtime_error If the grid is not compressed.
+    /// @throws std::out_of_range If an invalid cell id is provided.
+    template <class Function>
+    void enumerateNeighbourhood(const CellId& cell_id, Function&& function) const;
+
+    /// @brief Returns the number of cells holding data. The grid has to be compressed.
+    /// @return The number of occupied cells.
+    /// @throws std::runtime_error If the grid is not compressed.
+    size_t getNumOccupiedCells() const;
+
+    /// @brief Returns whether a cell holds data, by testing it's bit in the occupancy mask. The grid has to be
+    ///        compressed.
+    /// @param cell_id The id of the cell.
+    /// @return Whether the cell is occupied.
+    /// @throws std::runtime_error If the grid is not compressed.
+    /// @throws std::out_of_range If an invalid cell id is provided.
+    bool isOccupied(const CellId& cell_id) const;
+
+    /// @brief Visits the cells holding data in storage order, skipping the empty cells, so the cost of a sweep
+    ///        follows the number of data, instead of the number of cells. The grid has to be compressed.
+    /// @param function Called with the id of each occupied cell and the bounds of the data stored in it.
+    /// @throws std::runtime_error If the grid is not compressed.
+    template <class Function>
+    void forEachOccupiedCell(Function&& function) const;
+
+    /// @brief Enumerates the occupied cells of the 3^dim neighbourhood of the given cell (including the cell itself),
+    ///        clipped to the grid, skipping the empty neighbours by testing their bits in the occupancy mask. The grid
+    ///        has to be compressed.
+    /// @param cell_id The id of the cell.
+    /// @param function Called with the id of each occupied neighbour cell and the bounds of the data stored in it.
+    /// @throws std::runtime_error If the grid is not compressed.
+    /// @throws std::out_of_range If an invalid cell id is provided.
+    template <class Function>
+    void forEachOccupiedNeighbour(const CellId& cell_id, Function&& function) const;
+
+    /// @brief Computes the size of the tiles used by "traverseTiled()", such that the data of a tile and of it's one
+    ///        cell wide halo fits into a cache of the given size, based on the average occupancy of the cells.
+    /// @param cache_size The size of the cache in bytes.
+    /// @return The tile size along each dimension.
+    GridSize computeTileSize(size_t cache_size = kDefaultCacheSize) const;
+
+    /// @brief Visits each cell of the grid tile by tile, in row-major order inside each tile. Compared to a row-major
+    ///        traversal of the whole grid, neighbourhood queries issued from the visited cells reuse the cached data of
+    ///        the current tile, instead of reloading it for each row.
+    /// @param tile_size The number of cells there are in a tile along each dimension.
+    /// @param function Called with the id of each cell.
+    /// @throws std::runtime_error If any of the tile sizes is zero.
+    template <class Function>
+    void traverseTiled(const GridSize& tile_size, Function&& function) const;
+
+    /// @brief Computes the data of the next step in a single tiled sweep over the grid. The kernel is called once for
+    ///        each cell, so it can compute the interactions of the cell's data with it's neighbourhood (dispersion),
+    ///        advance them (advection) and emit the results directly into the binning buffer of the next grid, instead
+    ///        of streaming the data through memory in three separate sweeps. The grid has to be compressed.
+    /// @param next The grid receiving the data of the next step. It's buffered data is cleared before the sweep.
+    /// @param kernel Called as "kernel(cell_id, data_bounds, emitter)" for each cell, with the id of the cell, the data
+    ///               stored in it and an "Emitter" adding data to the next grid.
+    /// @param tile_size The tile size of the sweep. If not given, "computeTileSize()" is used.
+    /// @throws std::runtime_error If the grid is not compressed, or the next grid is the grid itself.
+    template <class Kernel>
+    void advance(MultiGrid& next, Kernel&& kernel) const;
+    template <class Kernel>
+    void advance(MultiGrid& next, Kernel&& kernel, const GridSize& tile_size) const;
+
+    /// @brief Sets how many cells ahead the data of the upcoming neighbour cells is prefetched by
+    ///        "enumerateNeighbourhood()". The hardware prefetchers do not anticipate the jumps between the data of
+    ///        neighbour cells in different rows, which becomes the bottleneck once the grid exceeds the caches.
+    /// @param prefetch_distance The prefetch distance in cells. Zero disables the prefetching.
+    void setPrefetchDistance(size_t prefetch_distance);
+
+    /// @brief Returns how many cells ahead the data of the upcoming neighbour cells is prefetched.
+    /// @return The prefetch distance in cells.
+    size_t getPrefetchDistance() const;
+
+    /// @brief Sets the way "compress()" writes the data to their compressed positions. Writing directly touches a
+    ///        random cache line for each data, which is read for ownership and evicted before it is filled, once the
+    ///        compressed data exceeds the last level cache. Buffering first groups the data by buckets of consecutive
+    ///        cells through small staging buffers written in batches, then scatters each bucket within it's cached
+    ///        range, at the cost of moving the data twice. The buffers are kept between compressions, so once buffering
+    ///        is used, the grid holds an additional copy of each data (and two indices), until the strategy is set to
+    ///        "ScatterStrategy::kDirect", which releases them. The default is direct writing. Applies to the
+    ///        compression by node types as well.
+    /// @param scatter_strategy The scatter strategy.
+    void setScatterStrategy(ScatterStrategy scatter_strategy);
+
+    /// @brief Returns the way "compress()" writes the data to their compressed positions.
+    /// @return The scatter strategy.
+    ScatterStrategy getScatterStrategy() const;
+
+    static constexpr size_t kDefaultCacheSize = 256 * 1024;   ///< The assumed L2 cache size in bytes
+    static constexpr size_t kDefaultPrefetchDistance = 2;     ///< The default prefetch distance in cells
+    static constexpr size_t kMaxPrefetchedBytesPerCell = 256; ///< The maximal prefetched amount of data of a cell
+    static constexpr size_t kLastLevelCacheSize = 8 << 20;    ///< The assumed last level cache size in bytes
+    static constexpr size_t kMaxNumScatterBuckets = 1024;     ///< The maximal number of buckets of buffered scatter
+    static constexpr size_t kScatterBatchSize = 256;          ///< The staged bytes per bucket of buffered scatter
+    static constexpr size_t kNumSubHistograms = 4;            ///< The number of interleaved sub-histograms
+    static constexpr size_t kMaxNumNodeTypes = 256;           ///< The maximal number of node types
+
 private:
 
     /// @brief Linearizes a cell id. Used for computing the storage id corresponding to the cell.
@@ -80,6 +628,60 @@ private:
     /// @return The storage id.
     size_t linearize(const CellId& cell_id) const;
 
+    /// @brief Computes the cell id corresponding to a storage id. The inverse of "linearize()".
+    /// @param storage_id The storage id.
+    /// @return The cell id.
+    CellId delinearize(size_t storage_id) const;
+
+    /// @brief Checks, that the grid sizes of this (fine) grid and of a coarse grid match the ratio of their cell sizes.
+    /// @param coarse_grid_size The grid size of the coarse grid.
+    /// @param ratio The ratio of the cell sizes along each dimension.
+    /// @param function_name The name of the calling function, used in the error message.
+    /// @throws std::runtime_error If the grid sizes do not match.
+    void checkRatio(const GridSize& coarse_grid_size, const GridSize& ratio, const char* function_name) const;
+
+    /// @brief Counts the buffered data in each cell. Repeated increments of the same counter wait for each other's
+    ///        stores, so small grids are counted into interleaved sub-histograms (consecutive data incrementing
+    ///        different counters), while larger grids count runs of data in the same cell (e.g. data emitted in the
+    ///        compressed order of a previous step) in a register.
+    void countData();
+
+    /// @brief Computes the starting ids of the data in the compressed format from the number of data in each cell,
+    ///        along with the list and the bit mask of the occupied cells.
+    void computeFirstDataIds();
+
+    /// @brief Visits each cell of a box of cells in row-major order.
+    /// @param begin The smallest cell id of the box.
+    /// @param end The cell id past the largest cell id of the box along each dimension.
+    /// @param function Called with the id of each cell.
+    template <class Function>
+    static void forEachCellInBox(const CellId& begin, const CellId& end, Function&& function);
+
+    /// @brief Writes the buffered data to their compressed positions with the set scatter strategy, recording the
+    ///        permutation if requested. The data is grouped by slots (cells, or node types of cells), whose ranges
+    ///        follow each other in the compressed data, and whose next data ids are in "next_data_id_per_cell_buff".
+    /// @param num_slots The number of slots.
+    /// @param slot_of Called as "slot_of(raw_data_id)" for each data, returning the id of it's slot.
+    template <class SlotOf>
+    void scatter(size_t num_slots, SlotOf&& slot_of);
+
+    /// @brief Writes the buffered data to their compressed positions, one by one.
+    /// @tparam record_permutation Whether the id of each data in the raw data is recorded as well.
+    /// @param slot_of Called as "slot_of(raw_data_id)" for each data, returning the id of it's slot.
+    template <bool record_permutation, class SlotOf>
+    void scatterDirect(SlotOf&& slot_of);
+
+    /// @brief Writes the buffered data to their compressed positions through per bucket staging buffers.
+    /// @tparam record_permutation Whether the id of each data in the raw data is recorded as well.
+    /// @param num_slots The number of slots.
+    /// @param slot_of Called as "slot_of(raw_data_id)" for each data, returning the id of it's slot.
+    template <bool record_permutation, class SlotOf>
+    void scatterBuffered(size_t num_slots, SlotOf&& slot_of);
+
+    /// @brief Prefetches the beginning of the compressed data of a cell.
+    /// @param storage_id The storage id of the cell.
+    void prefetchCell(size_t storage_id) const;
+
     /// @brief The stored data in uncompressed form.
     struct RawData
     {
@@ -90,26 +692,84 @@ private:
     /// @brief The stored data in compressed form.
     struct CompressedData
     {
-        std::vector<Data> data;                         ///< The stored data in a compressed format
-        std::vector<size_t> num_data_per_cell;          ///< The number of datas stored in each cell of the grid
-        std::vector<size_t> first_data_id_per_cell;     ///< The id of the first data stored in each cell
-        std::vector<size_t> next_data_id_per_cell_buff; ///< Buffer used for initializing the compressed data
+        DataVector data;                               ///< The stored data in a compressed format
+        std::vector<Index> num_data_per_cell;          ///< The number of datas stored in each cell of the grid
+        std::vector<Index> first_data_id_per_cell;     ///< The id of the first data stored in each cell
+        std::vector<Index> next_data_id_per_cell_buff; ///< Buffer used for initializing the compressed data
+        std::vector<Index> raw_data_ids;               ///< The id of each compressed data in the raw data
+        bool has_permutation = false;                  ///< Whether "raw_data_ids" is recorded for the current data
+        std::vector<Index> sub_histograms_buff;        ///< Buffer for the interleaved sub-histograms of "countData()"
+        std::vector<Index> occupied_cells;             ///< The storage ids of the cells holding data, in storage order
+        std::vector<uint64_t> occupancy_mask;          ///< A bit for each cell, set if the cell holds data
+        size_t num_node_types = 0;                     ///< The number of node types partitioning the cells, or zero
+        std::vector<Index> first_data_id_per_type;     ///< The id of the first data of each node type of each cell
+        std::vector<uint8_t> node_types_buff;          ///< Buffer for the node type of each buffered data
+        bool has_occupancy_table = false;              ///< Whether the occupancy table is built for the current data
+        std::vector<Index> occupancy_table;            ///< The summed-area table of the number of data per cell
+    };
+
+    /// @brief A data staged by the buffered scatter, with it's destination.
+    struct ScatterEntry
+    {
+        Data data;         ///< The data
+        Index slot_id;     ///< The slot (cell, or node type of a cell) of the data
+        Index raw_data_id; ///< The id of the data in the raw data
+    };
+
+    /// @brief Buffers of the buffered scatter, kept between compressions.
+    struct ScatterBuffers
+    {
+        std::vector<ScatterEntry> entries;  ///< The data grouped by buckets
+        std::vector<ScatterEntry> staging;  ///< The staging buffer of each bucket
+        std::vector<size_t> num_staged;     ///< The number of data in the staging buffer of each bucket
+        std::vector<size_t> next_entry_ids; ///< The id of the next entry written by each bucket
     };
 
-    GridSize grid_size_;             ///< The number of cells there are in the grid along each dimension
-    size_t num_cells_;               ///< The gross number of cells in the grid
-    bool compressed_;                ///< Whether the stored data is compressed
-    RawData raw_data_;               ///< The stored data in uncompressed form
-    CompressedData compressed_data_; ///< The stored data in compressed form
+    GridSize grid_size_;               ///< The number of cells there are in the grid along each dimension
+    size_t num_cells_;                 ///< The gross number of cells in the grid
+    bool compressed_;                  ///< Whether the stored data is compressed
+    size_t prefetch_distance_;         ///< How many cells ahead the neighbour cells are prefetched
+    ScatterStrategy scatter_strategy_; ///< The way "compress()" writes the data to their compressed positions
+    bool record_permutation_;          ///< Whether the compressions record their permutation
+    RawData raw_data_;                 ///< The stored data in uncompressed form
+    CompressedData compressed_data_;   ///< The stored data in compressed form
+    ScatterBuffers scatter_buffers_;   ///< Buffers of the buffered scatter
 };
 
 //======================================================================================================================
 
-template <size_t dim, class Data>
-MultiGrid<dim, Data>::MultiGrid(GridSize grid_size, size_t buff_size)
+template <size_t dim, class Data, class Index>
+constexpr size_t MultiGrid<dim, Data, Index>::kDefaultCacheSize;
+
+template <size_t dim, class Data, class Index>
+constexpr size_t MultiGrid<dim, Data, Index>::kDefaultPrefetchDistance;
+
+template <size_t dim, class Data, class Index>
+constexpr size_t MultiGrid<dim, Data, Index>::kMaxPrefetchedBytesPerCell;
+
+template <size_t dim, class Data, class Index>
+constexpr size_t MultiGrid<dim, Data, Index>::kLastLevelCacheSize;
+
+template <size_t dim, class Data, class Index>
+constexpr size_t MultiGrid<dim, Data, Index>::kMaxNumScatterBuckets;
+
+template <size_t dim, class Data, class Index>
+constexpr size_t MultiGrid<dim, Data, Index>::kScatterBatchSize;
+
+template <size_t dim, class Data, class Index>
+constexpr size_t MultiGrid<dim, Data, Index>::kNumSubHistograms;
+
+template <size_t dim, class Data, class Index>
+constexpr size_t MultiGrid<dim, Data, Index>::kMaxNumNodeTypes;
+
+template <size_t dim, class Data, class Index>
+MultiGrid<dim, Data, Index>::MultiGrid(GridSize grid_size, size_t buff_size)
     : grid_size_(std::move(grid_size))
-    , num_cells_(std::accumulate(grid_size_.begin(), grid_size_.end(), 1, std::multiplies<size_t>()))
+    , num_cells_(std::accumulate(grid_size_.begin(), grid_size_.end(), size_t(1), std::multiplies<size_t>()))
     , compressed_(false)
+    , prefetch_distance_(kDefaultPrefetchDistance)
+    , scatter_strategy_(ScatterStrategy::kDirect)
+    , record_permutation_(false)
 {
     for (size_t i = 0; i < dim; ++i)
     {
@@ -119,6 +779,11 @@ MultiGrid<dim, Data>::MultiGrid(GridSize grid_size, size_t buff_size)
         }
     }
 
+    if (num_cells_ > std::numeric_limits<Index>::max())
+    {
+        throw std::runtime_error("The number of cells exceeds the range of the index type!");
+    }
+
     raw_data_.data.reserve(buff_size);
     raw_data_.cell_ids.reserve(buff_size);
 
@@ -128,8 +793,8 @@ MultiGrid<dim, Data>::MultiGrid(GridSize grid_size, size_t buff_size)
     compressed_data_.next_data_id_per_cell_buff.resize(num_cells_, 0);
 }
 
-template <size_t dim, class Data>
-void MultiGrid<dim, Data>::add(const CellId& cell_id, Data&& data)
+template <size_t dim, class Data, class Index>
+void MultiGrid<dim, Data, Index>::add(const CellId& cell_id, Data&& data)
 {
     for (size_t i = 0; i < dim; ++i)
     {
@@ -148,8 +813,8 @@ void MultiGrid<dim, Data>::add(const CellId& cell_id, Data&& data)
     raw_data_.cell_ids.push_back(cell_id);
 }
 
-template <size_t dim, class Data>
-void MultiGrid<dim, Data>::clear()
+template <size_t dim, class Data, class Index>
+void MultiGrid<dim, Data, Index>::clear()
 {
     if (compressed_)
     {
@@ -160,47 +825,219 @@ void MultiGrid<dim, Data>::clear()
     raw_data_.cell_ids.clear();
 }
 
-template <size_t dim, class Data>
-void MultiGrid<dim, Data>::compress()
+template <size_t dim, class Data, class Index>
+void MultiGrid<dim, Data, Index>::reserve(size_t buff_size)
+{
+    raw_data_.data.reserve(buff_size);
+    raw_data_.cell_ids.reserve(buff_size);
+    compressed_data_.data.reserve(buff_size);
+}
+
+template <size_t dim, class Data, class Index>
+void MultiGrid<dim, Data, Index>::compress()
 {
     if (compressed_)
     {
         return;
     }
 
-    // Compute how much data is stored in each cell
-    std::fill(compressed_data_.num_data_per_cell.begin(), compressed_data_.num_data_per_cell.end(), 0);
-    for (const auto& cell_id : raw_data_.cell_ids)
+    if (raw_data_.data.size() > std::numeric_limits<Index>::max())
     {
-        const auto storage_id = linearize(cell_id);
-        ++compressed_data_.num_data_per_cell[storage_id];
+        throw std::runtime_error("MultiGrid::compress(): The number of data exceeds the range of the index type!");
     }
 
+    // Compute how much data is stored in each cell
+    countData();
+
     // Compute the starting ids of data in the compressed fromat for each cell
-    std::fill(compressed_data_.first_data_id_per_cell.begin(), compressed_data_.first_data_id_per_cell.end(), 0);
-    size_t first_data_id_buff = 0;
-    for (size_t i = 0; i < num_cells_; ++i)
-    {
-        compressed_data_.first_data_id_per_cell[i] = first_data_id_buff;
-        first_data_id_buff += compressed_data_.num_data_per_cell[i];
-    }
+    computeFirstDataIds();
 
     // Write the compressed data
-    compressed_data_.data.resize(raw_data_.data.size());
     compressed_data_.next_data_id_per_cell_buff = compressed_data_.first_data_id_per_cell;
+    scatter(num_cells_, [this](size_t raw_data_id) { return linearize(raw_data_.cell_ids[raw_data_id]); });
+
+    compressed_data_.has_permutation = record_permutation_;
+    compressed_data_.num_node_types = 0;
+    compressed_data_.has_occupancy_table = false;
+    compressed_ = true;
+}
+
+template <size_t dim, class Data, class Index>
+template <class NodeTypeOf>
+void MultiGrid<dim, Data, Index>::compress(size_t num_node_types, NodeTypeOf&& node_type_of)
+{
+    if (num_node_types == 0 || num_node_types > kMaxNumNodeTypes)
+    {
+        throw std::runtime_error("MultiGrid::compress(): Invalid number of node types!");
+    }
+
+    if (raw_data_.data.size() > std::numeric_limits<Index>::max())
+    {
+        throw std::runtime_error("MultiGrid::compress(): The number of data exceeds the range of the index type!");
+    }
+
+    compressed_ = false;
+
+    // Count the data of each node type in each cell, the types of a cell following each other
     const auto num_raw_data = raw_data_.data.size();
+    auto& first_data_id_per_type = compressed_data_.first_data_id_per_type;
+    auto& node_types = compressed_data_.node_types_buff;
+    first_data_id_per_type.assign(num_cells_ * num_node_types + 1, 0);
+    node_types.resize(num_raw_data);
     for (size_t i = 0; i < num_raw_data; ++i)
     {
-        const auto storage_id = linearize(raw_data_.cell_ids[i]);
-        const auto next_data_id = compressed_data_.next_data_id_per_cell_buff[storage_id]++;
-        compressed_data_.data[next_data_id] = raw_data_.data[i];
+        const auto node_type = static_cast<size_t>(node_type_of(static_cast<const Data&>(raw_data_.data[i])));
+        if (node_type >= num_node_types)
+        {
+            throw std::out_of_range("MultiGrid::compress(): Invalid node type!");
+        }
+        node_types[i] = static_cast<uint8_t>(node_type);
+        ++first_data_id_per_type[linearize(raw_data_.cell_ids[i]) * num_node_types + node_type];
+    }
+
+    // The ranges of the types, the last entry being the number of data
+    detail::exclusiveScan(first_data_id_per_type.data(), first_data_id_per_type.data(), first_data_id_per_type.size());
+    for (size_t i = 0; i < num_cells_; ++i)
+    {
+        compressed_data_.num_data_per_cell[i] = static_cast<Index>(first_data_id_per_type[(i + 1) * num_node_types]
+                                                                   - first_data_id_per_type[i * num_node_types]);
     }
+    computeFirstDataIds();
+
+    // Write the compressed data, the node types of the cells being the slots
+    compressed_data_.next_data_id_per_cell_buff = first_data_id_per_type;
+    scatter(num_cells_ * num_node_types, [&](size_t raw_data_id)
+    {
+        return linearize(raw_data_.cell_ids[raw_data_id]) * num_node_types + node_types[raw_data_id];
+    });
 
+    compressed_data_.has_permutation = record_permutation_;
+    compressed_data_.num_node_types = num_node_types;
+    compressed_data_.has_occupancy_table = false;
     compressed_ = true;
 }
 
-template <size_t dim, class Data>
-typename MultiGrid<dim, Data>::DataBounds MultiGrid<dim, Data>::enumerateData(const CellId& cell_id) const
+template <size_t dim, class Data, class Index>
+std::future<void> MultiGrid<dim, Data, Index>::compressAsync(ThreadPool& pool)
+{
+    return pool.submit([this]() { compress(); });
+}
+
+template <size_t dim, class Data, class Index>
+void MultiGrid<dim, Data, Index>::compressRegion(const CellId& begin, const CellId& end, Region& region) const
+{
+    size_t num_region_cells = 1;
+    for (size_t i = 0; i < dim; ++i)
+    {
+        if (begin[i] >= end[i] || end[i] > grid_size_[i])
+        {
+            throw std::out_of_range("MultiGrid::compressRegion(): Invalid region!");
+        }
+        num_region_cells *= end[i] - begin[i];
+    }
+
+    if (!compressed_ && raw_data_.data.size() > std::numeric_limits<Index>::max())
+    {
+        throw std::runtime_error(
+            "MultiGrid::compressRegion(): The number of data exceeds the range of the index type!");
+    }
+
+    region.begin_ = begin;
+    region.end_ = end;
+    auto& first_data_ids = region.first_data_id_per_cell_;
+    first_data_ids.assign(num_region_cells + 1, 0);
+
+    if (compressed_)
+    {
+        // Gather the ranges of the cells in the box
+        size_t local_id = 0;
+        forEachCellInBox(begin, end, [&](const CellId& cell_id)
+        {
+            first_data_ids[local_id + 1] = first_data_ids[local_id]
+                                           + compressed_data_.num_data_per_cell[linearize(cell_id)];
+            ++local_id;
+        });
+
+        region.data_.resize(first_data_ids.back());
+        local_id = 0;
+        forEachCellInBox(begin, end, [&](const CellId& cell_id)
+        {
+            const auto data_begin = compressed_data_.data.begin()
+                                    + compressed_data_.first_data_id_per_cell[linearize(cell_id)];
+            std::copy(data_begin, data_begin + (first_data_ids[local_id + 1] - first_data_ids[local_id]),
+                      region.data_.begin() + first_data_ids[local_id]);
+            ++local_id;
+        });
+        return;
+    }
+
+    // Count the buffered data in each cell of the box, remembering their local cell ids
+    auto& local_ids = region.local_ids_buff_;
+    local_ids.clear();
+    const auto num_raw_data = raw_data_.data.size();
+    for (size_t i = 0; i < num_raw_data; ++i)
+    {
+        const auto& cell_id = raw_data_.cell_ids[i];
+        size_t local_id = 0;
+        size_t mult = 1;
+        bool inside = true;
+        for (size_t j = 0; j < dim; ++j)
+        {
+            inside = inside && cell_id[j] >= begin[j] && cell_id[j] < end[j];
+            local_id += (cell_id[j] - begin[j]) * mult;
+            mult *= end[j] - begin[j];
+        }
+
+        if (inside)
+        {
+            local_ids.push_back(static_cast<Index>(i));
+            local_ids.push_back(static_cast<Index>(local_id));
+            ++first_data_ids[local_id + 1];
+        }
+    }
+
+    for (size_t i = 0; i < num_region_cells; ++i)
+    {
+        first_data_ids[i + 1] += first_data_ids[i];
+    }
+
+    // Write the data of the box, using the counts as the next data ids
+    region.data_.resize(first_data_ids.back());
+    for (size_t i = 0; i < local_ids.size(); i += 2)
+    {
+        region.data_[first_data_ids[local_ids[i + 1]]++] = raw_data_.data[local_ids[i]];
+    }
+
+    // Restore the first data ids, that were shifted by one cell by the writing
+    for (size_t i = num_region_cells; i > 0; --i)
+    {
+        first_data_ids[i] = first_data_ids[i - 1];
+    }
+    first_data_ids[0] = 0;
+}
+
+template <size_t dim, class Data, class Index>
+typename MultiGrid<dim, Data, Index>::DataBounds MultiGrid<dim, Data, Index>::Region::enumerateData(
+    const CellId& cell_id) const
+{
+    size_t local_id = 0;
+    size_t mult = 1;
+    for (size_t i = 0; i < dim; ++i)
+    {
+        if (cell_id[i] < begin_[i] || cell_id[i] >= end_[i])
+        {
+            throw std::out_of_range("MultiGrid::Region::enumerateData(): The cell is outside of the region!");
+        }
+
+        local_id += (cell_id[i] - begin_[i]) * mult;
+        mult *= end_[i] - begin_[i];
+    }
+
+    return { data_.begin() + first_data_id_per_cell_[local_id], data_.begin() + first_data_id_per_cell_[local_id + 1] };
+}
+
+template <size_t dim, class Data, class Index>
+typename MultiGrid<dim, Data, Index>::DataBounds MultiGrid<dim, Data, Index>::enumerateData(const CellId& cell_id) const
 {
     if (!compressed_)
     {
@@ -221,8 +1058,750 @@ typename MultiGrid<dim, Data>::DataBounds MultiGrid<dim, Data>::enumerateData(co
     return { begin_it, end_it };
 }
 
-template <size_t dim, class Data>
-size_t MultiGrid<dim, Data>::linearize(const CellId& cell_id) const
+template <size_t dim, class Data, class Index>
+typename MultiGrid<dim, Data, Index>::DataIdBounds MultiGrid<dim, Data, Index>::enumerateDataIds(
+    const CellId& cell_id) const
+{
+    if (!compressed_)
+    {
+        throw std::runtime_error("MultiGrid::enumerateDataIds(): The grid has to be compressed!");
+    }
+
+    if (!compressed_data_.has_permutation)
+    {
+        throw std::runtime_error("MultiGrid::enumerateDataIds(): The permutation was not recorded!");
+    }
+
+    for (size_t i = 0; i < dim; ++i)
+    {
+        if (cell_id[i] >= grid_size_[i])
+        {
+            throw std::out_of_range("MultiGrid::enumerateDataIds(): Invalid cell id!");
+        }
+    }
+
+    const auto storage_id = linearize(cell_id);
+    const auto begin = compressed_data_.first_data_id_per_cell[storage_id];
+    return { begin, static_cast<Index>(begin + compressed_data_.num_data_per_cell[storage_id]) };
+}
+
+template <size_t dim, class Data, class Index>
+typename MultiGrid<dim, Data, Index>::DataBounds MultiGrid<dim, Data, Index>::enumerateData(const CellId& cell_id,
+                                                                                            size_t node_type) const
+{
+    if (!compressed_ || compressed_data_.num_node_types == 0)
+    {
+        throw std::runtime_error("MultiGrid::enumerateData(): The grid has to be compressed by node types!");
+    }
+
+    if (node_type >= compressed_data_.num_node_types)
+    {
+        throw std::out_of_range("MultiGrid::enumerateData(): Invalid node type!");
+    }
+
+    for (size_t i = 0; i < dim; ++i)
+    {
+        if (cell_id[i] >= grid_size_[i])
+        {
+            throw std::out_of_range("MultiGrid::enumerateData(): Invalid cell id!");
+        }
+    }
+
+    const auto type_id = linearize(cell_id) * compressed_data_.num_node_types + node_type;
+    const auto begin_it = compressed_data_.data.begin() + compressed_data_.first_data_id_per_type[type_id];
+    const auto end_it = compressed_data_.data.begin() + compressed_data_.first_data_id_per_type[type_id + 1];
+    return { begin_it, end_it };
+}
+
+template <size_t dim, class Data, class Index>
+typename MultiGrid<dim, Data, Index>::DataIdBounds MultiGrid<dim, Data, Index>::enumerateDataIds(
+    const CellId& cell_id, size_t node_type) const
+{
+    if (!compressed_ || compressed_data_.num_node_types == 0)
+    {
+        throw std::runtime_error("MultiGrid::enumerateDataIds(): The grid has to be compressed by node types!");
+    }
+
+    if (!compressed_data_.has_permutation)
+    {
+        throw std::runtime_error("MultiGrid::enumerateDataIds(): The permutation was not recorded!");
+    }
+
+    if (node_type >= compressed_data_.num_node_types)
+    {
+        throw std::out_of_range("MultiGrid::enumerateDataIds(): Invalid node type!");
+    }
+
+    for (size_t i = 0; i < dim; ++i)
+    {
+        if (cell_id[i] >= grid_size_[i])
+        {
+            throw std::out_of_range("MultiGrid::enumerateDataIds(): Invalid cell id!");
+        }
+    }
+
+    const auto type_id = linearize(cell_id) * compressed_data_.num_node_types + node_type;
+    return { compressed_data_.first_data_id_per_type[type_id], compressed_data_.first_data_id_per_type[type_id + 1] };
+}
+
+template <size_t dim, class Data, class Index>
+size_t MultiGrid<dim, Data, Index>::getNumNodeTypes() const
+{
+    return compressed_ ? compressed_data_.num_node_types : 0;
+}
+
+template <size_t dim, class Data, class Index>
+template <class Value>
+void MultiGrid<dim, Data, Index>::reorder(const std::vector<Value>& raw_values, std::vector<Value>& values) const
+{
+    if (!compressed_)
+    {
+        throw std::runtime_error("MultiGrid::reorder(): The grid has to be compressed!");
+    }
+
+    if (!compressed_data_.has_permutation)
+    {
+        throw std::runtime_error("MultiGrid::reorder(): The permutation was not recorded!");
+    }
+
+    const auto num_data = compressed_data_.raw_data_ids.size();
+    if (raw_values.size() != num_data)
+    {
+        throw std::runtime_error("MultiGrid::reorder(): The number of values differs from the number of data!");
+    }
+
+    values.resize(num_data);
+    const auto* raw_data_ids = compressed_data_.raw_data_ids.data();
+    for (size_t i = 0; i < num_data; ++i)
+    {
+        values[i] = raw_values[raw_data_ids[i]];
+    }
+}
+
+template <size_t dim, class Data, class Index>
+void MultiGrid<dim, Data, Index>::setRecordPermutation(bool record_permutation)
+{
+    record_permutation_ = record_permutation;
+    if (!record_permutation_)
+    {
+        std::vector<Index>().swap(compressed_data_.raw_data_ids);
+        compressed_data_.has_permutation = false;
+    }
+}
+
+template <size_t dim, class Data, class Index>
+bool MultiGrid<dim, Data, Index>::isRecordingPermutation() const
+{
+    return record_permutation_;
+}
+
+template <size_t dim, class Data, class Index>
+const typename MultiGrid<dim, Data, Index>::GridSize& MultiGrid<dim, Data, Index>::getGridSize() const
+{
+    return grid_size_;
+}
+
+template <size_t dim, class Data, class Index>
+size_t MultiGrid<dim, Data, Index>::getNumData() const
+{
+    return raw_data_.data.size();
+}
+
+template <size_t dim, class Data, class Index>
+bool MultiGrid<dim, Data, Index>::isCompressed() const
+{
+    return compressed_;
+}
+
+template <size_t dim, class Data, class Index>
+const typename MultiGrid<dim, Data, Index>::DataVector& MultiGrid<dim, Data, Index>::getCompressedData() const
+{
+    if (!compressed_)
+    {
+        throw std::runtime_error("MultiGrid::getCompressedData(): The grid has to be compressed!");
+    }
+
+    return compressed_data_.data;
+}
+
+template <size_t dim, class Data, class Index>
+const std::vector<Index>& MultiGrid<dim, Data, Index>::getNumDataPerCell() const
+{
+    if (!compressed_)
+    {
+        throw std::runtime_error("MultiGrid::getNumDataPerCell(): The grid has to be compressed!");
+    }
+
+    return compressed_data_.num_data_per_cell;
+}
+
+template <size_t dim, class Data, class Index>
+const std::vector<Index>& MultiGrid<dim, Data, Index>::getFirstDataIdPerCell() const
+{
+    if (!compressed_)
+    {
+        throw std::runtime_error("MultiGrid::getFirstDataIdPerCell(): The grid has to be compressed!");
+    }
+
+    return compressed_data_.first_data_id_per_cell;
+}
+
+template <size_t dim, class Data, class Index>
+void MultiGrid<dim, Data, Index>::buildOccupancyTable(ThreadPool& pool)
+{
+    if (!compressed_)
+    {
+        throw std::runtime_error("MultiGrid::buildOccupancyTable(): The grid has to be compressed!");
+    }
+
+    // The table is padded by a zero plane at the beginning of each axis, so the entry of a cell id counts the data of
+    // the cells with smaller ids along all axes
+    std::array<size_t, dim> strides;
+    size_t table_size = 1;
+    for (size_t i = 0; i < dim; ++i)
+    {
+        strides[i] = table_size;
+        table_size *= size_t(grid_size_[i]) + 1;
+    }
+
+    auto& table = compressed_data_.occupancy_table;
+    table.assign(table_size, 0);
+    auto* table_data = table.data();
+    const auto* num_data_per_cell = compressed_data_.num_data_per_cell.data();
+    const size_t row_size = grid_size_[0];
+    pool.parallelFor(0, num_cells_ / row_size, [&](size_t chunk_begin, size_t chunk_end)
+    {
+        for (auto row_id = chunk_begin; row_id < chunk_end; ++row_id)
+        {
+            size_t offset = 1;
+            for (size_t i = 1, rest = row_id; i < dim; ++i)
+            {
+                offset += (rest % grid_size_[i] + 1) * strides[i];
+                rest /= grid_size_[i];
+            }
+            std::copy(num_data_per_cell + row_id * row_size, num_data_per_cell + (row_id + 1) * row_size,
+                      table_data + offset);
+        }
+    });
+
+    // Scan the lines along axis 0, then add the consecutive planes of the further axes
+    const auto line_size = row_size + 1;
+    pool.parallelFor(0, table_size / line_size, [&](size_t chunk_begin, size_t chunk_end)
+    {
+        for (auto line_id = chunk_begin; line_id < chunk_end; ++line_id)
+        {
+            auto* line = table_data + line_id * line_size;
+            for (size_t i = 1; i < line_size; ++i)
+            {
+                line[i] = static_cast<Index>(line[i] + line[i - 1]);
+            }
+        }
+    });
+
+    for (size_t axis = 1; axis < dim; ++axis)
+    {
+        const auto stride = strides[axis];
+        const auto num_planes = size_t(grid_size_[axis]) + 1;
+        pool.parallelFor(0, table_size / num_planes, [&](size_t chunk_begin, size_t chunk_end)
+        {
+            for (size_t plane = 1; plane < num_planes; ++plane)
+            {
+                for (auto i = chunk_begin; i < chunk_end;)
+                {
+                    const auto outer = i / stride;
+                    const auto segment_end = std::min(chunk_end, (outer + 1) * stride);
+                    auto* row = table_data + (outer * num_planes + plane) * stride - outer * stride;
+                    for (; i < segment_end; ++i)
+                    {
+                        row[i] = static_cast<Index>(row[i] + row[i - stride]);
+                    }
+                }
+            }
+        });
+    }
+
+    compressed_data_.has_occupancy_table = true;
+}
+
+template <size_t dim, class Data, class Index>
+size_t MultiGrid<dim, Data, Index>::countDataInBox(const CellId& begin, const CellId& end) const
+{
+    if (!compressed_ || !compressed_data_.has_occupancy_table)
+    {
+        throw std::runtime_error("MultiGrid::countDataInBox(): The occupancy table has to be built!");
+    }
+
+    std::array<size_t, dim> strides;
+    size_t stride = 1;
+    for (size_t i = 0; i < dim; ++i)
+    {
+        if (begin[i] > end[i] || end[i] > grid_size_[i])
+        {
+            throw std::out_of_range("MultiGrid::countDataInBox(): Invalid box!");
+        }
+
+        strides[i] = stride;
+        stride *= size_t(grid_size_[i]) + 1;
+    }
+
+    // Inclusion-exclusion over the corners of the box, the corners with an odd number of "begin" coordinates being
+    // subtracted. The intermediate sums may wrap around, the result does not.
+    size_t num_data = 0;
+    for (size_t corner = 0; corner < (size_t(1) << dim); ++corner)
+    {
+        size_t offset = 0;
+        size_t num_begins = 0;
+        for (size_t i = 0; i < dim; ++i)
+        {
+            if (((corner >> i) & 1) != 0)
+            {
+                offset += end[i] * strides[i];
+            }
+            else
+            {
+                offset += begin[i] * strides[i];
+                ++num_begins;
+            }
+        }
+
+        const size_t value = compressed_data_.occupancy_table[offset];
+        num_data = num_begins % 2 == 0 ? num_data + value : num_data - value;
+    }
+    return num_data;
+}
+
+template <size_t dim, class Data, class Index>
+void MultiGrid<dim, Data, Index>::coarsen(const MultiGrid& fine, const GridSize& ratio, ThreadPool& pool)
+{
+    if (!fine.compressed_)
+    {
+        throw std::runtime_error("MultiGrid::coarsen(): The fine grid has to be compressed!");
+    }
+
+    if (&fine == this)
+    {
+        throw std::runtime_error("MultiGrid::coarsen(): The fine grid has to differ from the current one!");
+    }
+
+    fine.checkRatio(grid_size_, ratio, "MultiGrid::coarsen()");
+
+    clear();
+
+    // The fine cells covered by a coarse cell
+    const auto fine_block = [&](const CellId& coarse_cell_id, CellId& begin, CellId& end)
+    {
+        for (size_t i = 0; i < dim; ++i)
+        {
+            begin[i] = static_cast<Index>(coarse_cell_id[i] * ratio[i]);
+            end[i] = static_cast<Index>(begin[i] + ratio[i]);
+        }
+    };
+
+    // Sum the number of data in the covered fine cells
+    pool.parallelFor(0, num_cells_, [&](size_t chunk_begin, size_t chunk_end)
+    {
+        for (size_t storage_id = chunk_begin; storage_id < chunk_end; ++storage_id)
+        {
+            CellId begin;
+            CellId end;
+            fine_block(delinearize(storage_id), begin, end);
+
+            size_t num_data = 0;
+            forEachCellInBox(begin, end, [&](const CellId& fine_cell_id)
+            {
+                num_data += fine.compressed_data_.num_data_per_cell[fine.linearize(fine_cell_id)];
+            });
+            compressed_data_.num_data_per_cell[storage_id] = static_cast<Index>(num_data);
+        }
+    });
+
+    computeFirstDataIds();
+
+    // Copy the ranges of the covered fine cells next to each other. The raw data mirrors the compressed data, so later
+    // additions can be compressed together with it.
+    const auto num_data = fine.compressed_data_.data.size();
+    compressed_data_.data.resize(num_data);
+    raw_data_.data.resize(num_data);
+    raw_data_.cell_ids.resize(num_data);
+    Index* raw_data_ids = nullptr;
+    if (record_permutation_)
+    {
+        compressed_data_.raw_data_ids.resize(num_data);
+        raw_data_ids = compressed_data_.raw_data_ids.data();
+    }
+    pool.parallelFor(0, num_cells_, [&](size_t chunk_begin, size_t chunk_end)
+    {
+        for (size_t storage_id = chunk_begin; storage_id < chunk_end; ++storage_id)
+        {
+            const auto cell_id = delinearize(storage_id);
+            CellId begin;
+            CellId end;
+            fine_block(cell_id, begin, end);
+
+            auto data_id = compressed_data_.first_data_id_per_cell[storage_id];
+            forEachCellInBox(begin, end, [&](const CellId& fine_cell_id)
+            {
+                const auto fine_storage_id = fine.linearize(fine_cell_id);
+                const auto fine_begin = fine.compressed_data_.first_data_id_per_cell[fine_storage_id];
+                const auto fine_end = fine_begin + fine.compressed_data_.num_data_per_cell[fine_storage_id];
+                for (auto fine_data_id = fine_begin; fine_data_id < fine_end; ++fine_data_id, ++data_id)
+                {
+                    compressed_data_.data[data_id] = fine.compressed_data_.data[fine_data_id];
+                    if (raw_data_ids)
+                    {
+                        raw_data_ids[data_id] = data_id;
+                    }
+                    raw_data_.data[data_id] = fine.compressed_data_.data[fine_data_id];
+                    raw_data_.cell_ids[data_id] = cell_id;
+                }
+            });
+        }
+    });
+
+    compressed_data_.has_permutation = record_permutation_;
+    compressed_data_.num_node_types = 0;
+    compressed_data_.has_occupancy_table = false;
+    compressed_ = true;
+}
+
+template <size_t dim, class Data, class Index>
+template <class Locate>
+void MultiGrid<dim, Data, Index>::refine(const MultiGrid& coarse, const GridSize& ratio, Locate&& locate,
+                                         ThreadPool& pool)
+{
+    if (!coarse.compressed_)
+    {
+        throw std::runtime_error("MultiGrid::refine(): The coarse grid has to be compressed!");
+    }
+
+    if (&coarse == this)
+    {
+        throw std::runtime_error("MultiGrid::refine(): The coarse grid has to differ from the current one!");
+    }
+
+    checkRatio(coarse.grid_size_, ratio, "MultiGrid::refine()");
+
+    clear();
+
+    // Locate the fine cell of each data, and count the data per fine cell. Each fine cell is covered by a single
+    // coarse cell, so the chunks of coarse cells write disjoint counters.
+    const auto num_data = coarse.compressed_data_.data.size();
+    std::vector<size_t> fine_storage_ids(num_data);
+    std::fill(compressed_data_.num_data_per_cell.begin(), compressed_data_.num_data_per_cell.end(), 0);
+    pool.parallelFor(0, coarse.num_cells_, [&](size_t chunk_begin, size_t chunk_end)
+    {
+        for (size_t coarse_storage_id = chunk_begin; coarse_storage_id < chunk_end; ++coarse_storage_id)
+        {
+            const auto coarse_cell_id = coarse.delinearize(coarse_storage_id);
+            const auto coarse_begin = coarse.compressed_data_.first_data_id_per_cell[coarse_storage_id];
+            const auto coarse_end = coarse_begin + coarse.compressed_data_.num_data_per_cell[coarse_storage_id];
+            for (auto coarse_data_id = coarse_begin; coarse_data_id < coarse_end; ++coarse_data_id)
+            {
+                const CellId offset = locate(coarse_cell_id, coarse.compressed_data_.data[coarse_data_id]);
+                CellId cell_id;
+                for (size_t i = 0; i < dim; ++i)
+                {
+                    if (offset[i] >= ratio[i])
+                    {
+                        throw std::out_of_range("MultiGrid::refine(): Invalid fine cell offset!");
+                    }
+                    cell_id[i] = coarse_cell_id[i] * ratio[i] + offset[i];
+                }
+
+                const auto storage_id = linearize(cell_id);
+                fine_storage_ids[coarse_data_id] = storage_id;
+                ++compressed_data_.num_data_per_cell[storage_id];
+            }
+        }
+    });
+
+    computeFirstDataIds();
+
+    // Scatter the data of each coarse cell into it's fine cells
+    compressed_data_.data.resize(num_data);
+    raw_data_.data.resize(num_data);
+    raw_data_.cell_ids.resize(num_data);
+    Index* raw_data_ids = nullptr;
+    if (record_permutation_)
+    {
+        compressed_data_.raw_data_ids.resize(num_data);
+        raw_data_ids = compressed_data_.raw_data_ids.data();
+    }
+    compressed_data_.next_data_id_per_cell_buff = compressed_data_.first_data_id_per_cell;
+    pool.parallelFor(0, coarse.num_cells_, [&](size_t chunk_begin, size_t chunk_end)
+    {
+        const auto data_begin = coarse.compressed_data_.first_data_id_per_cell[chunk_begin];
+        const auto data_end = coarse.compressed_data_.first_data_id_per_cell[chunk_end - 1]
+                              + coarse.compressed_data_.num_data_per_cell[chunk_end - 1];
+        for (auto coarse_data_id = data_begin; coarse_data_id < data_end; ++coarse_data_id)
+        {
+            const auto storage_id = fine_storage_ids[coarse_data_id];
+            const auto data_id = compressed_data_.next_data_id_per_cell_buff[storage_id]++;
+            compressed_data_.data[data_id] = coarse.compressed_data_.data[coarse_data_id];
+            if (raw_data_ids)
+            {
+                raw_data_ids[data_id] = data_id;
+            }
+            raw_data_.data[data_id] = coarse.compressed_data_.data[coarse_data_id];
+            raw_data_.cell_ids[data_id] = delinearize(storage_id);
+        }
+    });
+
+    compressed_data_.has_permutation = record_permutation_;
+    compressed_data_.num_node_types = 0;
+    compressed_data_.has_occupancy_table = false;
+    compressed_ = true;
+}
+
+template <size_t dim, class Data, class Index>
+template <class Function>
+void MultiGrid<dim, Data, Index>::enumerateNeighbourhood(const CellId& cell_id, Function&& function) const
+{
+    if (!compressed_)
+    {
+        throw std::runtime_error("MultiGrid::enumerateNeighbourhood(): The grid has to be compressed!");
+    }
+
+    CellId begin;
+    CellId end;
+    for (size_t i = 0; i < dim; ++i)
+    {
+        if (cell_id[i] >= grid_size_[i])
+        {
+            throw std::out_of_range("MultiGrid::enumerateNeighbourhood(): Invalid cell id!");
+        }
+
+        begin[i] = cell_id[i] > 0 ? static_cast<Index>(cell_id[i] - 1) : 0;
+        end[i] = static_cast<Index>(std::min<size_t>(size_t(cell_id[i]) + 2, grid_size_[i]));
+    }
+
+    std::array<CellId, detail::neighbourhoodSize(dim)> neighbour_ids;
+    std::array<size_t, detail::neighbourhoodSize(dim)> storage_ids;
+    size_t num_neighbours = 0;
+    forEachCellInBox(begin, end, [&](const CellId& neighbour_id)
+    {
+        neighbour_ids[num_neighbours] = neighbour_id;
+        storage_ids[num_neighbours] = linearize(neighbour_id);
+        ++num_neighbours;
+    });
+
+    for (size_t i = 0; i < std::min(prefetch_distance_, num_neighbours); ++i)
+    {
+        prefetchCell(storage_ids[i]);
+    }
+
+    for (size_t i = 0; i < num_neighbours; ++i)
+    {
+        if (prefetch_distance_ > 0 && i + prefetch_distance_ < num_neighbours)
+        {
+            prefetchCell(storage_ids[i + prefetch_distance_]);
+        }
+
+        const auto storage_id = storage_ids[i];
+        const auto begin_it = compressed_data_.data.begin() + compressed_data_.first_data_id_per_cell[storage_id];
+        const auto end_it = begin_it + compressed_data_.num_data_per_cell[storage_id];
+        function(static_cast<const CellId&>(neighbour_ids[i]), DataBounds{ begin_it, end_it });
+    }
+}
+
+template <size_t dim, class Data, class Index>
+size_t MultiGrid<dim, Data, Index>::getNumOccupiedCells() const
+{
+    if (!compressed_)
+    {
+        throw std::runtime_error("MultiGrid::getNumOccupiedCells(): The grid has to be compressed!");
+    }
+
+    return compressed_data_.occupied_cells.size();
+}
+
+template <size_t dim, class Data, class Index>
+bool MultiGrid<dim, Data, Index>::isOccupied(const CellId& cell_id) const
+{
+    if (!compressed_)
+    {
+        throw std::runtime_error("MultiGrid::isOccupied(): The grid has to be compressed!");
+    }
+
+    for (size_t i = 0; i < dim; ++i)
+    {
+        if (cell_id[i] >= grid_size_[i])
+        {
+            throw std::out_of_range("MultiGrid::isOccupied(): Invalid cell id!");
+        }
+    }
+
+    const auto storage_id = linearize(cell_id);
+    return ((compressed_data_.occupancy_mask[storage_id / 64] >> (storage_id % 64)) & 1) != 0;
+}
+
+template <size_t dim, class Data, class Index>
+template <class Function>
+void MultiGrid<dim, Data, Index>::forEachOccupiedCell(Function&& function) const
+{
+    if (!compressed_)
+    {
+        throw std::runtime_error("MultiGrid::forEachOccupiedCell(): The grid has to be compressed!");
+    }
+
+    for (const auto storage_id : compressed_data_.occupied_cells)
+    {
+        const auto begin_it = compressed_data_.data.begin() + compressed_data_.first_data_id_per_cell[storage_id];
+        const auto end_it = begin_it + compressed_data_.num_data_per_cell[storage_id];
+        function(delinearize(storage_id), DataBounds{ begin_it, end_it });
+    }
+}
+
+template <size_t dim, class Data, class Index>
+template <class Function>
+void MultiGrid<dim, Data, Index>::forEachOccupiedNeighbour(const CellId& cell_id, Function&& function) const
+{
+    if (!compressed_)
+    {
+        throw std::runtime_error("MultiGrid::forEachOccupiedNeighbour(): The grid has to be compressed!");
+    }
+
+    CellId begin;
+    CellId end;
+    for (size_t i = 0; i < dim; ++i)
+    {
+        if (cell_id[i] >= grid_size_[i])
+        {
+            throw std::out_of_range("MultiGrid::forEachOccupiedNeighbour(): Invalid cell id!");
+        }
+
+        begin[i] = cell_id[i] > 0 ? static_cast<Index>(cell_id[i] - 1) : 0;
+        end[i] = static_cast<Index>(std::min<size_t>(size_t(cell_id[i]) + 2, grid_size_[i]));
+    }
+
+    const auto* occupancy_mask = compressed_data_.occupancy_mask.data();
+    forEachCellInBox(begin, end, [&](const CellId& neighbour_id)
+    {
+        const auto storage_id = linearize(neighbour_id);
+        if (((occupancy_mask[storage_id / 64] >> (storage_id % 64)) & 1) != 0)
+        {
+            const auto begin_it = compressed_data_.data.begin() + compressed_data_.first_data_id_per_cell[storage_id];
+            const auto end_it = begin_it + compressed_data_.num_data_per_cell[storage_id];
+            function(neighbour_id, DataBounds{ begin_it, end_it });
+        }
+    });
+}
+
+template <size_t dim, class Data, class Index>
+typename MultiGrid<dim, Data, Index>::GridSize MultiGrid<dim, Data, Index>::computeTileSize(size_t cache_size) const
+{
+    // Each cell costs it's average payload, and the per-cell bookkeeping read by the queries
+    const auto num_data = static_cast<double>(raw_data_.data.size());
+    const auto bytes_per_cell = num_data / num_cells_ * sizeof(Data) + 2 * sizeof(Index);
+    const auto num_cells_per_cache = static_cast<double>(cache_size) / bytes_per_cell;
+
+    // The tile is a hypercube, whose halo is also loaded by the neighbourhood queries
+    const auto edge_with_halo = std::pow(num_cells_per_cache, 1.0 / dim);
+    const auto edge = edge_with_halo > 3.0 ? static_cast<size_t>(edge_with_halo) - 2 : 1;
+
+    GridSize tile_size;
+    for (size_t i = 0; i < dim; ++i)
+    {
+        tile_size[i] = static_cast<Index>(std::min<size_t>(edge, grid_size_[i]));
+    }
+    return tile_size;
+}
+
+template <size_t dim, class Data, class Index>
+template <class Function>
+void MultiGrid<dim, Data, Index>::traverseTiled(const GridSize& tile_size, Function&& function) const
+{
+    GridSize num_tiles;
+    for (size_t i = 0; i < dim; ++i)
+    {
+        if (tile_size[i] == 0)
+        {
+            throw std::runtime_error("MultiGrid::traverseTiled(): All tile sizes have to be greater, than zero!");
+        }
+
+        num_tiles[i] = (grid_size_[i] + tile_size[i] - 1) / tile_size[i];
+    }
+
+    forEachCellInBox(CellId{}, num_tiles, [&](const CellId& tile_id)
+    {
+        CellId begin;
+        CellId end;
+        for (size_t i = 0; i < dim; ++i)
+        {
+            begin[i] = static_cast<Index>(tile_id[i] * tile_size[i]);
+            end[i] = static_cast<Index>(std::min<size_t>(size_t(begin[i]) + tile_size[i], grid_size_[i]));
+        }
+
+        forEachCellInBox(begin, end, function);
+    });
+}
+
+template <size_t dim, class Data, class Index>
+template <class Kernel>
+void MultiGrid<dim, Data, Index>::advance(MultiGrid& next, Kernel&& kernel) const
+{
+    advance(next, std::forward<Kernel>(kernel), computeTileSize());
+}
+
+template <size_t dim, class Data, class Index>
+template <class Kernel>
+void MultiGrid<dim, Data, Index>::advance(MultiGrid& next, Kernel&& kernel, const GridSize& tile_size) const
+{
+    if (!compressed_)
+    {
+        throw std::runtime_error("MultiGrid::advance(): The grid has to be compressed!");
+    }
+
+    if (&next == this)
+    {
+        throw std::runtime_error("MultiGrid::advance(): The next grid has to differ from the current one!");
+    }
+
+    // Most of the data stays alive between steps, so the binning buffer of the next grid is sized up front
+    next.clear();
+    next.raw_data_.data.reserve(compressed_data_.data.size());
+    next.raw_data_.cell_ids.reserve(compressed_data_.data.size());
+
+    Emitter emitter(next);
+    traverseTiled(tile_size, [&](const CellId& cell_id)
+    {
+        const auto storage_id = linearize(cell_id);
+        const auto begin_it = compressed_data_.data.begin() + compressed_data_.first_data_id_per_cell[storage_id];
+        const auto end_it = begin_it + compressed_data_.num_data_per_cell[storage_id];
+        kernel(cell_id, DataBounds{ begin_it, end_it }, emitter);
+    });
+}
+
+template <size_t dim, class Data, class Index>
+void MultiGrid<dim, Data, Index>::setPrefetchDistance(size_t prefetch_distance)
+{
+    prefetch_distance_ = prefetch_distance;
+}
+
+template <size_t dim, class Data, class Index>
+size_t MultiGrid<dim, Data, Index>::getPrefetchDistance() const
+{
+    return prefetch_distance_;
+}
+
+template <size_t dim, class Data, class Index>
+void MultiGrid<dim, Data, Index>::setScatterStrategy(ScatterStrategy scatter_strategy)
+{
+    scatter_strategy_ = scatter_strategy;
+    if (scatter_strategy_ == ScatterStrategy::kDirect)
+    {
+        scatter_buffers_ = ScatterBuffers();
+    }
+}
+
+template <size_t dim, class Data, class Index>
+typename MultiGrid<dim, Data, Index>::ScatterStrategy MultiGrid<dim, Data, Index>::getScatterStrategy() const
+{
+    return scatter_strategy_;
+}
+
+template <size_t dim, class Data, class Index>
+size_t MultiGrid<dim, Data, Index>::linearize(const CellId& cell_id) const
 {
     size_t storage_id = 0;
     size_t mult = 1;
@@ -234,4 +1813,278 @@ size_t MultiGrid<dim, Data>::linearize(const CellId& cell_id) const
     return storage_id;
 }
 
+template <size_t dim, class Data, class Index>
+typename MultiGrid<dim, Data, Index>::CellId MultiGrid<dim, Data, Index>::delinearize(size_t storage_id) const
+{
+    CellId cell_id;
+    for (size_t i = 0; i < dim; ++i)
+    {
+        cell_id[i] = static_cast<Index>(storage_id % grid_size_[i]);
+        storage_id /= grid_size_[i];
+    }
+    return cell_id;
+}
+
+template <size_t dim, class Data, class Index>
+void MultiGrid<dim, Data, Index>::checkRatio(const GridSize& coarse_grid_size, const GridSize& ratio,
+                                      const char* function_name) const
+{
+    for (size_t i = 0; i < dim; ++i)
+    {
+        if (ratio[i] == 0 || coarse_grid_size[i] * ratio[i] != grid_size_[i])
+        {
+            throw std::runtime_error(std::string(function_name) + ": The grid sizes do not match the ratio!");
+        }
+    }
+}
+
+template <size_t dim, class Data, class Index>
+void MultiGrid<dim, Data, Index>::countData()
+{
+    auto& num_data_per_cell = compressed_data_.num_data_per_cell;
+    const auto num_raw_data = raw_data_.cell_ids.size();
+
+    if (num_cells_ * kNumSubHistograms * sizeof(Index) <= kDefaultCacheSize)
+    {
+        // The sub-histograms of a cell are adjacent, so they are reduced from the same cache line
+        auto& sub_histograms = compressed_data_.sub_histograms_buff;
+        sub_histograms.assign(num_cells_ * kNumSubHistograms, 0);
+        for (size_t i = 0; i < num_raw_data; ++i)
+        {
+            ++sub_histograms[linearize(raw_data_.cell_ids[i]) * kNumSubHistograms + i % kNumSubHistograms];
+        }
+
+        for (size_t i = 0; i < num_cells_; ++i)
+        {
+            Index num_data = 0;
+            for (size_t j = 0; j < kNumSubHistograms; ++j)
+            {
+                num_data = static_cast<Index>(num_data + sub_histograms[i * kNumSubHistograms + j]);
+            }
+            num_data_per_cell[i] = num_data;
+        }
+        return;
+    }
+
+    std::fill(num_data_per_cell.begin(), num_data_per_cell.end(), 0);
+    if (num_raw_data == 0)
+    {
+        return;
+    }
+
+    auto run_storage_id = linearize(raw_data_.cell_ids[0]);
+    Index run_length = 1;
+    for (size_t i = 1; i < num_raw_data; ++i)
+    {
+        const auto storage_id = linearize(raw_data_.cell_ids[i]);
+        if (storage_id == run_storage_id)
+        {
+            ++run_length;
+        }
+        else
+        {
+            num_data_per_cell[run_storage_id] = static_cast<Index>(num_data_per_cell[run_storage_id] + run_length);
+            run_storage_id = storage_id;
+            run_length = 1;
+        }
+    }
+    num_data_per_cell[run_storage_id] = static_cast<Index>(num_data_per_cell[run_storage_id] + run_length);
+}
+
+template <size_t dim, class Data, class Index>
+void MultiGrid<dim, Data, Index>::computeFirstDataIds()
+{
+    detail::exclusiveScan(compressed_data_.num_data_per_cell.data(), compressed_data_.first_data_id_per_cell.data(),
+                          num_cells_);
+
+    // Gather the occupied cells 64 at a time, a word of the mask each
+    const auto* num_data_per_cell = compressed_data_.num_data_per_cell.data();
+    auto& occupancy_mask = compressed_data_.occupancy_mask;
+    auto& occupied_cells = compressed_data_.occupied_cells;
+    occupancy_mask.resize((num_cells_ + 63) / 64);
+    occupied_cells.clear();
+    for (size_t word_id = 0; word_id < occupancy_mask.size(); ++word_id)
+    {
+        const auto word_begin = word_id * 64;
+        const auto word_end = std::min(word_begin + 64, num_cells_);
+        uint64_t word = 0;
+        for (size_t i = word_begin; i < word_end; ++i)
+        {
+            word |= uint64_t(num_data_per_cell[i] != 0) << (i - word_begin);
+        }
+        occupancy_mask[word_id] = word;
+
+        for (auto i = word_begin; word != 0; ++i, word >>= 1)
+        {
+            if ((word & 1) != 0)
+            {
+                occupied_cells.push_back(static_cast<Index>(i));
+            }
+        }
+    }
+}
+
+template <size_t dim, class Data, class Index>
+template <class Function>
+void MultiGrid<dim, Data, Index>::forEachCellInBox(const CellId& begin, const CellId& end, Function&& function)
+{
+    for (size_t i = 0; i < dim; ++i)
+    {
+        if (begin[i] >= end[i])
+        {
+            return;
+        }
+    }
+
+    CellId cell_id = begin;
+    while (true)
+    {
+        function(static_cast<const CellId&>(cell_id));
+
+        // Step to the next cell, the first dimension being the fastest changing one
+        size_t i = 0;
+        for (; i < dim; ++i)
+        {
+            if (++cell_id[i] < end[i])
+            {
+                break;
+            }
+            cell_id[i] = begin[i];
+        }
+
+        if (i == dim)
+        {
+            return;
+        }
+    }
+}
+
+template <size_t dim, class Data, class Index>
+template <class SlotOf>
+void MultiGrid<dim, Data, Index>::scatter(size_t num_slots, SlotOf&& slot_of)
+{
+    // The buffered entries store the slot ids as "Index", which may not cover the node types of all cells
+    const auto num_raw_data = raw_data_.data.size();
+    const auto buffered = (scatter_strategy_ == ScatterStrategy::kBuffered
+                           || (scatter_strategy_ == ScatterStrategy::kAuto && sizeof(Data) < detail::kCacheLineSize
+                               && num_raw_data * sizeof(Data) > kLastLevelCacheSize))
+                          && num_slots - 1 <= std::numeric_limits<Index>::max();
+
+    compressed_data_.data.resize(num_raw_data);
+    if (record_permutation_)
+    {
+        compressed_data_.raw_data_ids.resize(num_raw_data);
+        buffered ? scatterBuffered<true>(num_slots, slot_of) : scatterDirect<true>(slot_of);
+    }
+    else
+    {
+        buffered ? scatterBuffered<false>(num_slots, slot_of) : scatterDirect<false>(slot_of);
+    }
+}
+
+template <size_t dim, class Data, class Index>
+template <bool record_permutation, class SlotOf>
+void MultiGrid<dim, Data, Index>::scatterDirect(SlotOf&& slot_of)
+{
+    const auto num_raw_data = raw_data_.data.size();
+    for (size_t i = 0; i < num_raw_data; ++i)
+    {
+        const auto slot_id = slot_of(i);
+        const auto next_data_id = compressed_data_.next_data_id_per_cell_buff[slot_id]++;
+        compressed_data_.data[next_data_id] = raw_data_.data[i];
+        if (record_permutation)
+        {
+            compressed_data_.raw_data_ids[next_data_id] = static_cast<Index>(i);
+        }
+    }
+}
+
+template <size_t dim, class Data, class Index>
+template <bool record_permutation, class SlotOf>
+void MultiGrid<dim, Data, Index>::scatterBuffered(size_t num_slots, SlotOf&& slot_of)
+{
+    // Buckets of consecutive slots, whose data is a contiguous range of the compressed data
+    size_t bucket_shift = 0;
+    while (((num_slots - 1) >> bucket_shift) >= kMaxNumScatterBuckets)
+    {
+        ++bucket_shift;
+    }
+    const auto num_buckets = ((num_slots - 1) >> bucket_shift) + 1;
+    const auto batch_size = std::max<size_t>(1, kScatterBatchSize / sizeof(ScatterEntry));
+
+    auto& buffers = scatter_buffers_;
+    const auto num_raw_data = raw_data_.data.size();
+    buffers.entries.resize(num_raw_data);
+    buffers.staging.resize(num_buckets * batch_size);
+    buffers.num_staged.assign(num_buckets, 0);
+    buffers.next_entry_ids.resize(num_buckets);
+    for (size_t i = 0; i < num_buckets; ++i)
+    {
+        buffers.next_entry_ids[i] = compressed_data_.next_data_id_per_cell_buff[i << bucket_shift];
+    }
+
+    const auto flush = [&](size_t bucket_id, size_t num_staged)
+    {
+        const auto staging_begin = buffers.staging.begin() + bucket_id * batch_size;
+        const auto entries_begin = buffers.entries.begin() + buffers.next_entry_ids[bucket_id];
+        std::move(staging_begin, staging_begin + num_staged, entries_begin);
+        buffers.next_entry_ids[bucket_id] += num_staged;
+    };
+
+    // Group the data by buckets, writing the entries in batches
+    for (size_t i = 0; i < num_raw_data; ++i)
+    {
+        const auto slot_id = slot_of(i);
+        const auto bucket_id = slot_id >> bucket_shift;
+        auto& num_staged = buffers.num_staged[bucket_id];
+        auto& entry = buffers.staging[bucket_id * batch_size + num_staged];
+        entry.data = raw_data_.data[i];
+        entry.slot_id = static_cast<Index>(slot_id);
+        if (record_permutation)
+        {
+            entry.raw_data_id = static_cast<Index>(i);
+        }
+        if (++num_staged == batch_size)
+        {
+            flush(bucket_id, batch_size);
+            num_staged = 0;
+        }
+    }
+
+    for (size_t i = 0; i < num_buckets; ++i)
+    {
+        flush(i, buffers.num_staged[i]);
+    }
+
+    // Scatter the data of each bucket within it's range, preserving the order of addition inside the slots
+    for (auto& entry : buffers.entries)
+    {
+        const auto next_data_id = compressed_data_.next_data_id_per_cell_buff[entry.slot_id]++;
+        compressed_data_.data[next_data_id] = std::move(entry.data);
+        if (record_permutation)
+        {
+            compressed_data_.raw_data_ids[next_data_id] = entry.raw_data_id;
+        }
+    }
+}
+
+template <size_t dim, class Data, class Index>
+void MultiGrid<dim, Data, Index>::prefetchCell(size_t storage_id) const
+{
+    const auto num_data = compressed_data_.num_data_per_cell[storage_id];
+    if (num_data == 0)
+    {
+        return;
+    }
+
+    // Prefetching a whole, possibly crowded cell would evict the data being processed
+    const auto first_data_id = compressed_data_.first_data_id_per_cell[storage_id];
+    const auto* first = reinterpret_cast<const char*>(&compressed_data_.data[first_data_id]);
+    const auto num_bytes = std::min(num_data * sizeof(Data), kMaxPrefetchedBytesPerCell);
+    for (size_t offset = 0; offset < num_bytes; offset += detail::kCacheLineSize)
+    {
+        detail::prefetch(first + offset);
+    }
+}
+
 } // end namespace dire
@@ -0,0 +1,243 @@
+///
+/// @copyrightblock
+///
+///   NPOSL-3.0 License
+///
+///   Copyright(c) 2021 Mtys Lrnt-Nyeste
+///
+///   Licensed under the Non-Profit Open Software License, version 3.0 (the "License"); you may not use this file except
+///   in compliance with the License. You may obtain a copy of the License at:
+///
+///   https://opensource.org/licenses/NPOSL-3.0
+///
+///   Unless required by applicable law or agreed to in writing, software distributed under the License is distributed
+///   on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for
+///   the specific language governing permissionsand limitations under the License.
+///
+/// @endcopyrightblock
+///
+
+#pragma once
+
+#include "multi_grid.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+namespace dire {
+
+/// @brief An ensemble of independent grids of the same size, e.g. the cases of a parameter sweep. The data of the
+///        members is stored interleaved: the data of all members in a cell is stored next to each other, in member
+///        order, so a single sweep over the cells processes all members at once, and members with the same number of
+///        data in a cell map to consecutive (SIMD) lanes.
+/// @tparam dim The dimensionality of the grid of each member.
+/// @tparam Data The type of the stored data.
+/// @tparam Index The unsigned integer type of the cell ids and data ids of the underlying grid.
+template <size_t dim, class Data, class Index = size_t>
+class MultiGridEnsemble
+{
+private:
+
+    /// @brief The underlying grid, whose first (fastest changing) dimension is the member id.
+    using Grid = MultiGrid<dim + 1, Data, Index>;
+
+public:
+
+    using GridSize = std::array<Index, dim>;
+    using CellId = std::array<Index, dim>;
+    using DataBounds = typename Grid::DataBounds;
+
+    /// @brief Constructor.
+    /// @param num_members The number of members in the ensemble.
+    /// @param grid_size The number of cells there are in the grid of each member along each dimension.
+    /// @param buff_size The maximum number of data of all the members, that can be stored in the buffer.
+    /// @throws std::runtime_error If the number of members or any of the grid sizes is zero, or the number of cells of
+    ///                            the underlying grid exceeds the range of "Index".
+    MultiGridEnsemble(size_t num_members, const GridSize& grid_size, size_t buff_size = 0);
+
+    /// @brief Returns the number of members in the ensemble.
+    /// @return The number of members.
+    size_t getNumMembers() const;
+
+    /// @brief Adds a data to the given cell of the given member. Makes the ensemble uncompressed.
+    /// @param member_id The id of the member.
+    /// @param cell_id The id of the cell.
+    /// @param data The data.
+    /// @throws std::out_of_range If an invalid member or cell id is provided.
+    void add(size_t member_id, const CellId& cell_id, Data&& data);
+
+    /// @brief Clears all buffered data of all members. Makes the ensemble uncompressed.
+    void clear();
+
+    /// @brief Converts all members into a compressed format.
+    void compress();
+
+    /// @brief Enumerates all data of the given member in the given cell. The ensemble has to be compressed.
+    /// @param member_id The id of the member.
+    /// @param cell_id The id of the cell.
+    /// @return The enumerated data represented by it's begin and end iterators.
+    /// @throws std::runtime_error If the ensemble is not compressed.
+    /// @throws std::out_of_range If an invalid member or cell id is provided.
+    DataBounds enumerateData(size_t member_id, const CellId& cell_id) const;
+
+    /// @brief Enumerates all data of all members in the given cell, ordered by member id. The ensemble has to be
+    ///        compressed.
+    /// @param cell_id The id of the cell.
+    /// @return The enumerated data represented by it's begin and end iterators.
+    /// @throws std::runtime_error If the ensemble is not compressed.
+    /// @throws std::out_of_range If an invalid cell id is provided.
+    DataBounds enumerateData(const CellId& cell_id) const;
+
+    /// @brief Visits each cell on the worker threads of the given pool, handing the data of all members in the cell to
+    ///        the same call. Returns after all cells are visited. The cells are distributed in contiguous chunks, so
+    ///        calls for different cells may run concurrently.
+    /// @param pool The thread pool.
+    /// @param function Called with the id of each cell.
+    template <class Function>
+    void traverseParallel(ThreadPool& pool, Function&& function) const;
+
+private:
+
+    /// @brief Computes the id of the underlying grid's cell, corresponding to the given member and cell.
+    /// @param member_id The id of the member.
+    /// @param cell_id The id of the cell.
+    /// @return The id of the underlying grid's cell.
+    /// @throws std::out_of_range If an invalid member id is provided.
+    typename Grid::CellId toGridCellId(size_t member_id, const CellId& cell_id) const;
+
+    /// @brief Computes the cell id corresponding to a storage id, in the same row-major order as "MultiGrid".
+    /// @param storage_id The storage id.
+    /// @return The cell id.
+    CellId delinearize(size_t storage_id) const;
+
+    /// @brief Computes the grid size of the underlying grid.
+    /// @param num_members The number of members.
+    /// @param grid_size The grid size of each member.
+    /// @return The grid size of the underlying grid.
+    static typename Grid::GridSize toGridSize(size_t num_members, const GridSize& grid_size);
+
+    size_t num_members_; ///< The number of members in the ensemble
+    GridSize grid_size_; ///< The number of cells there are in the grid of each member along each dimension
+    size_t num_cells_;   ///< The gross number of cells in the grid of each member
+    Grid grid_;          ///< The underlying grid, storing the data of all members
+};
+
+//======================================================================================================================
+
+template <size_t dim, class Data, class Index>
+MultiGridEnsemble<dim, Data, Index>::MultiGridEnsemble(size_t num_members, const GridSize& grid_size, size_t buff_size)
+    : num_members_(num_members)
+    , grid_size_(grid_size)
+    , num_cells_(std::accumulate(grid_size.begin(), grid_size.end(), size_t(1), std::multiplies<size_t>()))
+    , grid_(toGridSize(num_members, grid_size), buff_size)
+{
+}
+
+template <size_t dim, class Data, class Index>
+size_t MultiGridEnsemble<dim, Data, Index>::getNumMembers() const
+{
+    return num_members_;
+}
+
+template <size_t dim, class Data, class Index>
+void MultiGridEnsemble<dim, Data, Index>::add(size_t member_id, const CellId& cell_id, Data&& data)
+{
+    grid_.add(toGridCellId(member_id, cell_id), std::move(data));
+}
+
+template <size_t dim, class Data, class Index>
+void MultiGridEnsemble<dim, Data, Index>::clear()
+{
+    grid_.clear();
+}
+
+template <size_t dim, class Data, class Index>
+void MultiGridEnsemble<dim, Data, Index>::compress()
+{
+    grid_.compress();
+}
+
+template <size_t dim, class Data, class Index>
+typename MultiGridEnsemble<dim, Data, Index>::DataBounds MultiGridEnsemble<dim, Data, Index>::enumerateData(
+    size_t member_id, const CellId& cell_id) const
+{
+    return grid_.enumerateData(toGridCellId(member_id, cell_id));
+}
+
+template <size_t dim, class Data, class Index>
+typename MultiGridEnsemble<dim, Data, Index>::DataBounds MultiGridEnsemble<dim, Data, Index>::enumerateData(
+    const CellId& cell_id) const
+{
+    // The data of the members is contiguous inside a cell
+    const auto first = grid_.enumerateData(toGridCellId(0, cell_id));
+    const auto last = grid_.enumerateData(toGridCellId(num_members_ - 1, cell_id));
+    return { first.begin, last.end };
+}
+
+template <size_t dim, class Data, class Index>
+template <class Function>
+void MultiGridEnsemble<dim, Data, Index>::traverseParallel(ThreadPool& pool, Function&& function) const
+{
+    pool.parallelFor(0, num_cells_, [&](size_t chunk_begin, size_t chunk_end)
+    {
+        for (size_t storage_id = chunk_begin; storage_id < chunk_end; ++storage_id)
+        {
+            function(delinearize(storage_id));
+        }
+    });
+}
+
+template <size_t dim, class Data, class Index>
+typename MultiGridEnsemble<dim, Data, Index>::Grid::CellId MultiGridEnsemble<dim, Data, Index>::toGridCellId(
+    size_t member_id, const CellId& cell_id) const
+{
+    if (member_id >= num_members_)
+    {
+        throw std::out_of_range("MultiGridEnsemble: Invalid member id!");
+    }
+
+    typename Grid::CellId grid_cell_id;
+    grid_cell_id[0] = static_cast<Index>(member_id);
+    std::copy(cell_id.begin(), cell_id.end(), grid_cell_id.begin() + 1);
+    return grid_cell_id;
+}
+
+template <size_t dim, class Data, class Index>
+typename MultiGridEnsemble<dim, Data, Index>::CellId MultiGridEnsemble<dim, Data, Index>::delinearize(
+    size_t storage_id) const
+{
+    CellId cell_id;
+    for (size_t i = 0; i < dim; ++i)
+    {
+        cell_id[i] = static_cast<Index>(storage_id % grid_size_[i]);
+        storage_id /= grid_size_[i];
+    }
+    return cell_id;
+}
+
+template <size_t dim, class Data, class Index>
+typename MultiGridEnsemble<dim, Data, Index>::Grid::GridSize MultiGridEnsemble<dim, Data, Index>::toGridSize(
+    size_t num_members, const GridSize& grid_size)
+{
+    if (num_members == 0)
+    {
+        throw std::runtime_error("The number of ensemble members has to be greater, than zero!");
+    }
+
+    if (num_members > std::numeric_limits<Index>::max())
+    {
+        throw std::runtime_error("MultiGridEnsemble: The number of members exceeds the range of the index type!");
+    }
+
+    typename Grid::GridSize size;
+    size[0] = static_cast<Index>(num_members);
+    std::copy(grid_size.begin(), grid_size.end(), size.begin() + 1);
+    return size;
+}
+
+} // end namespace dire
@@ -0,0 +1,192 @@
+///
+/// @copyrightblock
+///
+///   NPOSL-3.0 License
+///
+///   Copyright(c) 2021 Mtys Lrnt-Nyeste
+///
+///   Licensed under the Non-Profit Open Software License, version 3.0 (the "License"); you may not use this file except
+///   in compliance with the License. You may obtain a copy of the License at:
+///
+///   https://opensource.org/licenses/NPOSL-3.0
+///
+///   Unless required by applicable law or agreed to in writing, software distributed under the License is distributed
+///   on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for
+///   the specific language governing permissionsand limitations under the License.
+///
+/// @endcopyrightblock
+///
+
+#pragma once
+
+#include "multi_grid.hpp"
+#include "thread_pool.hpp"
+
+#include <deque>
+#include <future>
+#include <istream>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace dire {
+
+/// @brief Streams fixed size binary records (e.g. the seeded nodes of an initial condition) into a "MultiGrid", without
+///        materializing the whole input. The stream is read chunk by chunk on the calling thread, the chunks are parsed
+///        on the worker threads of a pool, and the parsed chunks are binned into the grid's buffer in input order,
+///        while the next chunks are being read and parsed. At most a few chunks are held in memory at once.
+/// @tparam dim The dimensionality of the grid.
+/// @tparam Data The type of the stored data.
+/// @tparam Index The unsigned integer type of the cell ids and data ids of the loaded grids.
+template <size_t dim, class Data, class Index = size_t>
+class MultiGridLoader
+{
+public:
+
+    using Grid = MultiGrid<dim, Data, Index>;
+    using CellId = typename Grid::CellId;
+
+    /// @brief Constructor.
+    /// @param record_size The size of a record in bytes.
+    /// @param records_per_chunk The number of records read and parsed together.
+    /// @throws std::runtime_error If the record size or the number of records per chunk is zero.
+    MultiGridLoader(size_t record_size, size_t records_per_chunk = kDefaultRecordsPerChunk);
+
+    /// @brief Loads all records from the current position of a stream to it's end, and adds them to a grid.
+    /// @param stream The binary stream.
+    /// @param parse Called as "parse(record, cell_id, data)" with a pointer to the bytes of each record, filling the
+    ///              cell id and the data of the node it describes. Called concurrently on the worker threads.
+    /// @param grid The grid, to which the nodes are added.
+    /// @param pool The thread pool parsing the chunks.
+    /// @return The number of loaded records.
+    /// @throws std::runtime_error If the stream ends with an incomplete record, or reading it fails.
+    /// @throws std::out_of_range If a parsed cell id is invalid. The records before it are left in the grid.
+    /// @throws Any exception thrown by the parser, after all chunks in flight have finished. The records of the chunks
+    ///         before it are left in the grid.
+    template <class Parse>
+    size_t load(std::istream& stream, Parse&& parse, Grid& grid, ThreadPool& pool) const;
+
+    static constexpr size_t kDefaultRecordsPerChunk = 1 << 16; ///< The default number of records per chunk
+
+private:
+
+    /// @brief The parsed nodes of a chunk.
+    struct Chunk
+    {
+        std::vector<CellId> cell_ids; ///< The cell ids of the nodes
+        std::vector<Data> data;       ///< The data of the nodes
+    };
+
+    size_t record_size_;       ///< The size of a record in bytes
+    size_t records_per_chunk_; ///< The number of records read and parsed together
+};
+
+template <size_t dim, class Data, class Index>
+constexpr size_t MultiGridLoader<dim, Data, Index>::kDefaultRecordsPerChunk;
+
+//======================================================================================================================
+
+template <size_t dim, class Data, class Index>
+MultiGridLoader<dim, Data, Index>::MultiGridLoader(size_t record_size, size_t records_per_chunk)
+    : record_size_(record_size)
+    , records_per_chunk_(records_per_chunk)
+{
+    if (record_size == 0 || records_per_chunk == 0)
+    {
+        throw std::runtime_error("The record size and the number of records per chunk have to be greater, than zero!");
+    }
+}
+
+template <size_t dim, class Data, class Index>
+template <class Parse>
+size_t MultiGridLoader<dim, Data, Index>::load(std::istream& stream, Parse&& parse, Grid& grid, ThreadPool& pool) const
+{
+    // Size the grid's buffers once, if the stream tells it's length
+    const auto start = stream.tellg();
+    if (start != std::istream::pos_type(-1) && stream.seekg(0, std::ios::end))
+    {
+        const auto num_bytes = static_cast<size_t>(stream.tellg() - start);
+        stream.seekg(start);
+        grid.reserve(grid.getNumData() + num_bytes / record_size_);
+    }
+    stream.clear();
+
+    // Enough chunks in flight to keep all workers busy while the oldest one is binned
+    const auto max_num_chunks_in_flight = 2 * pool.getNumThreads() + 1;
+    std::deque<std::future<Chunk>> chunks_in_flight;
+    size_t num_records = 0;
+
+    const auto bin_oldest_chunk = [&]()
+    {
+        // Popped before "get()", which invalidates the future, even if it rethrows the exception of the parser
+        auto future = std::move(chunks_in_flight.front());
+        chunks_in_flight.pop_front();
+        auto chunk = future.get();
+        for (size_t i = 0; i < chunk.data.size(); ++i)
+        {
+            grid.add(chunk.cell_ids[i], std::move(chunk.data[i]));
+        }
+    };
+
+    try
+    {
+        while (stream)
+        {
+            auto bytes = std::make_shared<std::vector<char>>(records_per_chunk_ * record_size_);
+            stream.read(bytes->data(), static_cast<std::streamsize>(bytes->size()));
+            const auto num_bytes = static_cast<size_t>(stream.gcount());
+            if (stream.bad())
+            {
+                throw std::runtime_error("MultiGridLoader::load(): Reading the stream failed!");
+            }
+            if (num_bytes % record_size_ != 0)
+            {
+                throw std::runtime_error("MultiGridLoader::load(): The stream ends with an incomplete record!");
+            }
+            if (num_bytes == 0)
+            {
+                break;
+            }
+
+            const auto num_chunk_records = num_bytes / record_size_;
+            num_records += num_chunk_records;
+            chunks_in_flight.push_back(pool.submit([this, bytes, num_chunk_records, &parse]()
+            {
+                Chunk chunk;
+                chunk.cell_ids.resize(num_chunk_records);
+                chunk.data.resize(num_chunk_records);
+                for (size_t i = 0; i < num_chunk_records; ++i)
+                {
+                    parse(static_cast<const char*>(bytes->data() + i * record_size_), chunk.cell_ids[i], chunk.data[i]);
+                }
+                return chunk;
+            }));
+
+            if (chunks_in_flight.size() >= max_num_chunks_in_flight)
+            {
+                bin_oldest_chunk();
+            }
+        }
+
+        while (!chunks_in_flight.empty())
+        {
+            bin_oldest_chunk();
+        }
+    }
+    catch (...)
+    {
+        // The chunks being parsed reference the parser
+        for (auto& chunk : chunks_in_flight)
+        {
+            if (chunk.valid())
+            {
+                chunk.wait();
+            }
+        }
+        throw;
+    }
+
+    return num_records;
+}
+
+} // end namespace dire
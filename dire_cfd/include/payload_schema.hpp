@@ -0,0 +1,512 @@
+///
+/// @copyrightblock
+///
+///   NPOSL-3.0 License
+///
+///   Copyright(c) 2021 Mtys Lrnt-Nyeste
+///
+///   Licensed under the Non-Profit Open Software License, version 3.0 (the "License"); you may not use this file except
+///   in compliance with the License. You may obtain a copy of the License at:
+///
+///   https://opensource.org/licenses/NPOSL-3.0
+///
+///   Unless required by applicable law or agreed to in writing, software distributed under the License is distributed
+///   on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for
+///   the specific language governing permissionsand limitations under the License.
+///
+/// @endcopyrightblock
+///
+
+#pragma once
+
+#include "multi_grid.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <istream>
+#include <iterator>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace dire {
+
+/// @brief Describes a field of a payload schema. The fields of a schema are declared by deriving from this struct, and
+///        providing the name of the field, e.g.:
+///        struct Velocity : dire::Field<float, 3> { static const char* name() { return "velocity"; } };
+/// @tparam Type The arithmetic type of the field's components, defining it's precision.
+/// @tparam count The number of components of the field.
+template <class Type, size_t count = 1>
+struct Field
+{
+    static_assert(std::is_arithmetic<Type>::value, "The type of a field has to be arithmetic.");
+    static_assert(count > 0, "The number of components of a field must be greater, than zero!");
+
+    using Value = Type;                     ///< The type of the field's components
+    static constexpr size_t kCount = count; ///< The number of components of the field
+};
+
+template <class Type, size_t count>
+constexpr size_t Field<Type, count>::kCount;
+
+/// @brief A contiguous range of elements, referring to storage owned by someone else.
+template <class Type>
+struct Span
+{
+    Type* data;  ///< The first element
+    size_t size; ///< The number of elements
+
+    Type* begin() const { return data; }
+    Type* end() const { return data + size; }
+    Type& operator[](size_t i) const { return data[i]; }
+};
+
+/// @brief The metadata of a field, used by exporters.
+struct FieldInfo
+{
+    const char* name;       ///< The name of the field
+    size_t value_size;      ///< The size of a component in bytes
+    size_t count;           ///< The number of components
+    bool is_floating_point; ///< Whether the components are floating point numbers
+    bool is_signed;         ///< Whether the components are signed
+};
+
+/// @brief A compile-time list of fields, from which the per-node record type, the structure of arrays (SoA) storage,
+///        it's binary serialization and the exporter metadata are generated.
+/// @tparam Index The unsigned integer type of the node ids, matching the data ids of the "MultiGrid" the records are
+///               stored in.
+/// @tparam Fields The fields, each derived from "Field".
+template <class Index, class... Fields>
+class BasicPayloadSchema
+{
+private:
+
+    static_assert(std::is_unsigned<Index>::value, "Index has to be an unsigned integer type.");
+    static_assert(sizeof...(Fields) > 0, "A schema has to have at least one field.");
+
+public:
+
+    static constexpr size_t kNumFields = sizeof...(Fields); ///< The number of fields
+
+    /// @brief The record holding all fields of a single node (array of structures form), usable as the data of
+    ///        "MultiGrid".
+    using Record = std::tuple<std::array<typename Fields::Value, Fields::kCount>...>;
+
+    /// @brief The grid storing the records of the schema, whose data ids are the node ids.
+    template <size_t dim>
+    using Grid = MultiGrid<dim, Record, Index>;
+
+    /// @brief Returns the metadata of the fields, in declaration order.
+    /// @return The metadata of the fields.
+    static std::array<FieldInfo, kNumFields> getFieldInfos()
+    {
+        return { { FieldInfo{ Fields::name(), sizeof(typename Fields::Value), Fields::kCount,
+                              std::is_floating_point<typename Fields::Value>::value,
+                              std::is_signed<typename Fields::Value>::value }... } };
+    }
+
+    /// @brief Computes the index of a field in the schema.
+    /// @tparam Field The field.
+    /// @return The index of the field.
+    template <class Field>
+    static constexpr size_t indexOf()
+    {
+        return IndexOf<Field, Fields...>::value;
+    }
+
+    /// @brief The nodes' data stored as a structure of arrays: the components of each field are stored contiguously
+    ///        in a separate array, node after node.
+    class SoaStorage
+    {
+    public:
+
+        /// @brief Returns the number of stored nodes.
+        /// @return The number of nodes.
+        Index size() const { return size_; }
+
+        /// @brief Resizes the storage to the given number of nodes.
+        /// @param size The number of nodes.
+        void resize(Index size);
+
+        /// @brief Returns the components of a field of all nodes. Invalidated by resizing.
+        /// @tparam Field The field.
+        /// @return The span of "size() * Field::kCount" components.
+        template <class Field>
+        Span<typename Field::Value> get();
+        template <class Field>
+        Span<const typename Field::Value> get() const;
+
+        /// @brief Sets all fields of a node from a record.
+        /// @param node_id The id of the node.
+        /// @param record The record.
+        void set(Index node_id, const Record& record);
+
+        /// @brief Gathers all fields of a node into a record.
+        /// @param node_id The id of the node.
+        /// @return The record.
+        Record getRecord(Index node_id) const;
+
+        /// @brief Replaces the stored nodes with the given records, e.g. the compressed data of a "MultiGrid".
+        /// @param begin The iterator of the first record.
+        /// @param end The iterator past the last record.
+        /// @throws std::runtime_error If the number of records exceeds the range of the index type.
+        template <class Iterator>
+        void assign(Iterator begin, Iterator end);
+
+        /// @brief Replaces the stored nodes with the compressed data of a grid storing the records of the schema, so
+        ///        the node ids are the data ids of the grid, and field-wise kernels or exporters can work on the arrays
+        ///        of the grid's nodes. The grid has to be compressed.
+        /// @param grid The grid.
+        /// @throws std::runtime_error If the grid is not compressed.
+        template <size_t dim>
+        void assign(const Grid<dim>& grid);
+
+        /// @brief Writes the schema and the stored nodes into a binary stream. The fields are written as raw arrays,
+        ///        in the native byte order.
+        /// @param stream The stream.
+        /// @throws std::runtime_error If writing fails.
+        void write(std::ostream& stream) const;
+
+        /// @brief Reads the nodes written by "write()" from a binary stream. The number of nodes is validated against
+        ///        the remaining length of the stream (if it is seekable), and the arrays grow while they are read, so a
+        ///        corrupt stream fails, instead of allocating the count it claims. The storage is only changed on
+        ///        success.
+        /// @param stream The stream.
+        /// @throws std::runtime_error If reading fails, the stream was written using a different schema, or it's number
+        ///                            of nodes exceeds the range of the index type or the length of the stream.
+        void read(std::istream& stream);
+
+    private:
+
+        using Arrays = std::tuple<std::vector<typename Fields::Value>...>;
+
+        template <size_t... field_ids>
+        void resize(Index size, std::index_sequence<field_ids...>);
+
+        template <size_t... field_ids>
+        void set(Index node_id, const Record& record, std::index_sequence<field_ids...>);
+
+        template <size_t... field_ids>
+        void getRecord(Index node_id, Record& record, std::index_sequence<field_ids...>) const;
+
+        template <size_t... field_ids>
+        void writeArrays(std::ostream& stream, std::index_sequence<field_ids...>) const;
+
+        template <size_t... field_ids>
+        static void readArrays(std::istream& stream, Arrays& arrays, size_t size, std::index_sequence<field_ids...>);
+
+        Index size_ = 0; ///< The number of stored nodes
+        Arrays arrays_;  ///< The components of each field
+    };
+
+private:
+
+    template <class Field, class... Others>
+    struct IndexOf;
+
+    template <class Field, class... Others>
+    struct IndexOf<Field, Field, Others...> : std::integral_constant<size_t, 0>
+    {
+    };
+
+    template <class Field, class Other, class... Others>
+    struct IndexOf<Field, Other, Others...> : std::integral_constant<size_t, 1 + IndexOf<Field, Others...>::value>
+    {
+    };
+
+    using FieldIds = std::index_sequence_for<Fields...>;
+
+    /// @brief Computes the number of bytes of the fields of a node in a serialized stream.
+    /// @return The number of bytes per node.
+    static constexpr size_t getNodeSize()
+    {
+        const size_t sizes[] = { sizeof(typename Fields::Value) * Fields::kCount... };
+        size_t node_size = 0;
+        for (const auto size : sizes)
+        {
+            node_size += size;
+        }
+        return node_size;
+    }
+
+    /// @brief The value written in front of the serialized schema, used for detecting foreign streams.
+    static constexpr uint32_t kMagic = 0x44695265; // "DiRe"
+};
+
+template <class Index, class... Fields>
+constexpr size_t BasicPayloadSchema<Index, Fields...>::kNumFields;
+
+template <class Index, class... Fields>
+constexpr uint32_t BasicPayloadSchema<Index, Fields...>::kMagic;
+
+/// @brief A payload schema with "size_t" node ids, matching the default "MultiGrid".
+template <class... Fields>
+using PayloadSchema = BasicPayloadSchema<size_t, Fields...>;
+
+//======================================================================================================================
+
+namespace detail {
+
+/// @brief Writes the raw bytes of an array into a binary stream.
+template <class Type>
+void writeRaw(std::ostream& stream, const Type* values, size_t count)
+{
+    stream.write(reinterpret_cast<const char*>(values), static_cast<std::streamsize>(count * sizeof(Type)));
+}
+
+/// @brief Reads the raw bytes of an array from a binary stream.
+template <class Type>
+void readRaw(std::istream& stream, Type* values, size_t count)
+{
+    stream.read(reinterpret_cast<char*>(values), static_cast<std::streamsize>(count * sizeof(Type)));
+}
+
+/// @brief Reads an array from a binary stream, growing it by a bounded chunk at a time, so the allocation follows the
+///        bytes actually present in the stream.
+template <class Type>
+void readRawGrowing(std::istream& stream, std::vector<Type>& values, size_t count)
+{
+    constexpr size_t kChunkSize = (size_t(1) << 20) / sizeof(Type) + 1;
+    values.clear();
+    while (values.size() < count && stream)
+    {
+        const auto offset = values.size();
+        values.resize(offset + std::min(count - offset, kChunkSize));
+        readRaw(stream, values.data() + offset, values.size() - offset);
+    }
+}
+
+/// @brief Returns the number of bytes left in a stream, or the maximal value, if the stream is not seekable.
+inline uint64_t getRemainingLength(std::istream& stream)
+{
+    const auto position = stream.tellg();
+    if (position == std::istream::pos_type(-1))
+    {
+        return std::numeric_limits<uint64_t>::max();
+    }
+
+    stream.seekg(0, std::ios::end);
+    const auto end = stream.tellg();
+    stream.clear();
+    stream.seekg(position);
+    if (end == std::istream::pos_type(-1) || end < position)
+    {
+        return std::numeric_limits<uint64_t>::max();
+    }
+    return static_cast<uint64_t>(end - position);
+}
+
+} // end namespace detail
+
+template <class Index, class... Fields>
+void BasicPayloadSchema<Index, Fields...>::SoaStorage::resize(Index size)
+{
+    resize(size, FieldIds());
+    size_ = size;
+}
+
+template <class Index, class... Fields>
+template <class Field>
+Span<typename Field::Value> BasicPayloadSchema<Index, Fields...>::SoaStorage::get()
+{
+    auto& array = std::get<indexOf<Field>()>(arrays_);
+    return { array.data(), array.size() };
+}
+
+template <class Index, class... Fields>
+template <class Field>
+Span<const typename Field::Value> BasicPayloadSchema<Index, Fields...>::SoaStorage::get() const
+{
+    const auto& array = std::get<indexOf<Field>()>(arrays_);
+    return { array.data(), array.size() };
+}
+
+template <class Index, class... Fields>
+void BasicPayloadSchema<Index, Fields...>::SoaStorage::set(Index node_id, const Record& record)
+{
+    set(node_id, record, FieldIds());
+}
+
+template <class Index, class... Fields>
+typename BasicPayloadSchema<Index, Fields...>::Record BasicPayloadSchema<Index, Fields...>::SoaStorage::getRecord(
+    Index node_id) const
+{
+    Record record;
+    getRecord(node_id, record, FieldIds());
+    return record;
+}
+
+template <class Index, class... Fields>
+template <class Iterator>
+void BasicPayloadSchema<Index, Fields...>::SoaStorage::assign(Iterator begin, Iterator end)
+{
+    const auto size = std::distance(begin, end);
+    if (static_cast<uint64_t>(size) > std::numeric_limits<Index>::max())
+    {
+        throw std::runtime_error("PayloadSchema::SoaStorage::assign(): The number of records exceeds the index type!");
+    }
+    resize(static_cast<Index>(size));
+
+    Index node_id = 0;
+    for (auto it = begin; it != end; ++it)
+    {
+        set(node_id++, *it);
+    }
+}
+
+template <class Index, class... Fields>
+template <size_t dim>
+void BasicPayloadSchema<Index, Fields...>::SoaStorage::assign(const Grid<dim>& grid)
+{
+    if (!grid.isCompressed())
+    {
+        throw std::runtime_error("PayloadSchema::SoaStorage::assign(): The grid has to be compressed!");
+    }
+
+    const auto& data = grid.getCompressedData();
+    assign(data.begin(), data.end());
+}
+
+template <class Index, class... Fields>
+void BasicPayloadSchema<Index, Fields...>::SoaStorage::write(std::ostream& stream) const
+{
+    const uint32_t num_fields = kNumFields;
+    const uint64_t num_nodes = size_;
+    detail::writeRaw(stream, &kMagic, 1);
+    detail::writeRaw(stream, &num_fields, 1);
+    for (const auto& info : getFieldInfos())
+    {
+        const uint32_t name_length = static_cast<uint32_t>(std::strlen(info.name));
+        const uint32_t value_size = static_cast<uint32_t>(info.value_size);
+        const uint32_t count = static_cast<uint32_t>(info.count);
+        detail::writeRaw(stream, &name_length, 1);
+        detail::writeRaw(stream, info.name, name_length);
+        detail::writeRaw(stream, &value_size, 1);
+        detail::writeRaw(stream, &count, 1);
+    }
+    detail::writeRaw(stream, &num_nodes, 1);
+    writeArrays(stream, FieldIds());
+
+    if (!stream)
+    {
+        throw std::runtime_error("PayloadSchema::SoaStorage::write(): Writing the stream failed!");
+    }
+}
+
+template <class Index, class... Fields>
+void BasicPayloadSchema<Index, Fields...>::SoaStorage::read(std::istream& stream)
+{
+    uint32_t magic = 0;
+    uint32_t num_fields = 0;
+    detail::readRaw(stream, &magic, 1);
+    detail::readRaw(stream, &num_fields, 1);
+    if (!stream || magic != kMagic || num_fields != kNumFields)
+    {
+        throw std::runtime_error("PayloadSchema::SoaStorage::read(): The stream was written using a different schema!");
+    }
+
+    for (const auto& info : getFieldInfos())
+    {
+        uint32_t name_length = 0;
+        uint32_t value_size = 0;
+        uint32_t count = 0;
+        detail::readRaw(stream, &name_length, 1);
+        if (!stream || name_length != std::strlen(info.name))
+        {
+            throw std::runtime_error(
+                "PayloadSchema::SoaStorage::read(): The stream was written using a different schema!");
+        }
+
+        std::string name(name_length, '\0');
+        detail::readRaw(stream, &name[0], name.size());
+        detail::readRaw(stream, &value_size, 1);
+        detail::readRaw(stream, &count, 1);
+        if (!stream || name != info.name || value_size != info.value_size || count != info.count)
+        {
+            throw std::runtime_error(
+                "PayloadSchema::SoaStorage::read(): The stream was written using a different schema!");
+        }
+    }
+
+    uint64_t num_nodes = 0;
+    detail::readRaw(stream, &num_nodes, 1);
+    if (!stream)
+    {
+        throw std::runtime_error("PayloadSchema::SoaStorage::read(): Reading the stream failed!");
+    }
+    if (num_nodes > std::numeric_limits<Index>::max() ||
+        num_nodes > std::numeric_limits<size_t>::max() / getNodeSize() ||
+        num_nodes > detail::getRemainingLength(stream) / getNodeSize())
+    {
+        throw std::runtime_error("PayloadSchema::SoaStorage::read(): The number of nodes is invalid!");
+    }
+
+    Arrays arrays;
+    readArrays(stream, arrays, static_cast<size_t>(num_nodes), FieldIds());
+    if (!stream)
+    {
+        throw std::runtime_error("PayloadSchema::SoaStorage::read(): Reading the stream failed!");
+    }
+
+    arrays_.swap(arrays);
+    size_ = static_cast<Index>(num_nodes);
+}
+
+template <class Index, class... Fields>
+template <size_t... field_ids>
+void BasicPayloadSchema<Index, Fields...>::SoaStorage::resize(Index size, std::index_sequence<field_ids...>)
+{
+    (void)std::initializer_list<int>{ (std::get<field_ids>(arrays_).resize(size * Fields::kCount), 0)... };
+}
+
+template <class Index, class... Fields>
+template <size_t... field_ids>
+void BasicPayloadSchema<Index, Fields...>::SoaStorage::set(Index node_id, const Record& record,
+                                                           std::index_sequence<field_ids...>)
+{
+    (void)std::initializer_list<int>{ (std::copy(std::get<field_ids>(record).begin(),
+                                                 std::get<field_ids>(record).end(),
+                                                 std::get<field_ids>(arrays_).begin() + node_id * Fields::kCount),
+                                       0)... };
+}
+
+template <class Index, class... Fields>
+template <size_t... field_ids>
+void BasicPayloadSchema<Index, Fields...>::SoaStorage::getRecord(Index node_id, Record& record,
+                                                                 std::index_sequence<field_ids...>) const
+{
+    (void)std::initializer_list<int>{ (std::copy_n(std::get<field_ids>(arrays_).begin() + node_id * Fields::kCount,
+                                                   Fields::kCount,
+                                                   std::get<field_ids>(record).begin()),
+                                       0)... };
+}
+
+template <class Index, class... Fields>
+template <size_t... field_ids>
+void BasicPayloadSchema<Index, Fields...>::SoaStorage::writeArrays(std::ostream& stream,
+                                                                   std::index_sequence<field_ids...>) const
+{
+    (void)std::initializer_list<int>{ (detail::writeRaw(stream, std::get<field_ids>(arrays_).data(),
+                                                        std::get<field_ids>(arrays_).size()),
+                                       0)... };
+}
+
+template <class Index, class... Fields>
+template <size_t... field_ids>
+void BasicPayloadSchema<Index, Fields...>::SoaStorage::readArrays(std::istream& stream, Arrays& arrays, size_t size,
+                                                                  std::index_sequence<field_ids...>)
+{
+    (void)std::initializer_list<int>{ (detail::readRawGrowing(stream, std::get<field_ids>(arrays),
+                                                              size * Fields::kCount),
+                                       0)... };
+}
+
+} // end namespace dire
@@ -0,0 +1,303 @@
+///
+/// @copyrightblock
+///
+///   NPOSL-3.0 License
+///
+///   Copyright(c) 2021 Mtys Lrnt-Nyeste
+///
+///   Licensed under the Non-Profit Open Software License, version 3.0 (the "License"); you may not use this file except
+///   in compliance with the License. You may obtain a copy of the License at:
+///
+///   https://opensource.org/licenses/NPOSL-3.0
+///
+///   Unless required by applicable law or agreed to in writing, software distributed under the License is distributed
+///   on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for
+///   the specific language governing permissionsand limitations under the License.
+///
+/// @endcopyrightblock
+///
+
+#pragma once
+
+#include "multi_grid.hpp"
+
+#include <initializer_list>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace dire {
+
+/// @brief Optional scalar quantities transported by the nodes of a "MultiGrid" (e.g. temperature, species
+///        concentrations), stored outside of the grid's data, each in a separate array. Each channel is filled
+///        parallel to the data added to the grid, and is reordered with the grid's compression permutation. Inactive
+///        channels are neither stored nor reordered. Only grids attached to channels record their permutation, one
+///        index per data on each compression.
+/// @tparam Scalar The floating point type of the scalars.
+template <class Scalar>
+class ScalarChannels
+{
+private:
+
+    static_assert(std::is_floating_point<Scalar>::value, "Scalar has to be a floating point type.");
+
+public:
+
+    /// @brief Constructor. All channels are active.
+    /// @param num_channels The number of channels.
+    explicit ScalarChannels(size_t num_channels);
+
+    /// @brief Returns the number of channels.
+    /// @return The number of channels.
+    size_t getNumChannels() const;
+
+    /// @brief Makes the compressions of a grid record their permutation, as needed by "compress()". Has to be called
+    ///        before the grid is compressed.
+    /// @param grid The grid, to which the nodes are added.
+    template <size_t dim, class Data, class Index>
+    static void attach(MultiGrid<dim, Data, Index>& grid);
+
+    /// @brief Activates or deactivates a channel. Deactivating a channel releases it's values.
+    /// @param channel_id The id of the channel.
+    /// @param active Whether the channel is active.
+    /// @throws std::out_of_range If an invalid channel id is provided.
+    void setActive(size_t channel_id, bool active);
+
+    /// @brief Returns whether a channel is active.
+    /// @param channel_id The id of the channel.
+    /// @return Whether the channel is active.
+    /// @throws std::out_of_range If an invalid channel id is provided.
+    bool isActive(size_t channel_id) const;
+
+    /// @brief Adds the values of a node, which is added to the grid at the same time.
+    /// @param values The values of all channels. The values of inactive channels are ignored.
+    /// @throws std::runtime_error If the number of values differs from the number of channels.
+    void add(std::initializer_list<Scalar> values);
+
+    /// @brief Clears the values added since the last compression, like "MultiGrid::clear()".
+    void clear();
+
+    /// @brief Returns the values of a channel parallel to the data added to the grid, for filling them directly.
+    /// @param channel_id The id of the channel.
+    /// @return The values in the order of addition.
+    /// @throws std::out_of_range If an invalid channel id is provided.
+    std::vector<Scalar>& getRawValues(size_t channel_id);
+
+    /// @brief Returns the values of a channel in the compressed order of the grid, valid after "compress()".
+    /// @param channel_id The id of the channel.
+    /// @return The values in the compressed order.
+    /// @throws std::out_of_range If an invalid channel id is provided.
+    std::vector<Scalar>& getValues(size_t channel_id);
+    const std::vector<Scalar>& getValues(size_t channel_id) const;
+
+    /// @brief Reorders the active channels into the compressed order of the grid. As the scalars are carried by the
+    ///        nodes, this is their advection. The grid has to be attached and compressed.
+    /// @param grid The grid, to which the nodes were added.
+    /// @throws std::runtime_error If the grid is not compressed, it's permutation was not recorded, or the number of
+    ///                            values of an active channel differs from the number of data in the grid.
+    template <size_t dim, class Data, class Index>
+    void compress(const MultiGrid<dim, Data, Index>& grid);
+
+    /// @brief Disperses the active channels by intra-cell mixing: each value is relaxed towards the mean of it's cell.
+    ///        Values are not exchanged between neighbour cells, so the total of each channel in each cell is conserved,
+    ///        and transport across cells is left to the advection by "compress()". Only the occupied cells are visited.
+    ///        The grid has to be compressed, and the channels have to be compressed using it.
+    /// @param grid The grid.
+    /// @param rate The relaxation rate in [0, 1]; 1 replaces each value by the mean of it's cell.
+    /// @throws std::runtime_error If the grid is not compressed, or the number of values of an active channel differs
+    ///                            from the number of data in the grid.
+    template <size_t dim, class Data, class Index>
+    void disperse(const MultiGrid<dim, Data, Index>& grid, Scalar rate);
+
+private:
+
+    /// @brief Checks a channel id.
+    /// @param channel_id The id of the channel.
+    /// @throws std::out_of_range If an invalid channel id is provided.
+    void checkChannelId(size_t channel_id) const;
+
+    /// @brief A single scalar channel.
+    struct Channel
+    {
+        bool active = true;             ///< Whether the channel is stored and transported
+        std::vector<Scalar> raw_values; ///< The values in the order of addition
+        std::vector<Scalar> values;     ///< The values in the compressed order
+    };
+
+    std::vector<Channel> channels_; ///< The channels
+};
+
+//======================================================================================================================
+
+template <class Scalar>
+ScalarChannels<Scalar>::ScalarChannels(size_t num_channels)
+    : channels_(num_channels)
+{
+}
+
+template <class Scalar>
+size_t ScalarChannels<Scalar>::getNumChannels() const
+{
+    return channels_.size();
+}
+
+template <class Scalar>
+template <size_t dim, class Data, class Index>
+void ScalarChannels<Scalar>::attach(MultiGrid<dim, Data, Index>& grid)
+{
+    grid.setRecordPermutation(true);
+}
+
+template <class Scalar>
+void ScalarChannels<Scalar>::setActive(size_t channel_id, bool active)
+{
+    checkChannelId(channel_id);
+
+    auto& channel = channels_[channel_id];
+    channel.active = active;
+    if (!active)
+    {
+        std::vector<Scalar>().swap(channel.raw_values);
+        std::vector<Scalar>().swap(channel.values);
+    }
+}
+
+template <class Scalar>
+bool ScalarChannels<Scalar>::isActive(size_t channel_id) const
+{
+    checkChannelId(channel_id);
+    return channels_[channel_id].active;
+}
+
+template <class Scalar>
+void ScalarChannels<Scalar>::add(std::initializer_list<Scalar> values)
+{
+    if (values.size() != channels_.size())
+    {
+        throw std::runtime_error("ScalarChannels::add(): The number of values differs from the number of channels!");
+    }
+
+    auto value_it = values.begin();
+    for (auto& channel : channels_)
+    {
+        if (channel.active)
+        {
+            channel.raw_values.push_back(*value_it);
+        }
+        ++value_it;
+    }
+}
+
+template <class Scalar>
+void ScalarChannels<Scalar>::clear()
+{
+    for (auto& channel : channels_)
+    {
+        channel.raw_values.clear();
+    }
+}
+
+template <class Scalar>
+std::vector<Scalar>& ScalarChannels<Scalar>::getRawValues(size_t channel_id)
+{
+    checkChannelId(channel_id);
+    return channels_[channel_id].raw_values;
+}
+
+template <class Scalar>
+std::vector<Scalar>& ScalarChannels<Scalar>::getValues(size_t channel_id)
+{
+    checkChannelId(channel_id);
+    return channels_[channel_id].values;
+}
+
+template <class Scalar>
+const std::vector<Scalar>& ScalarChannels<Scalar>::getValues(size_t channel_id) const
+{
+    checkChannelId(channel_id);
+    return channels_[channel_id].values;
+}
+
+template <class Scalar>
+template <size_t dim, class Data, class Index>
+void ScalarChannels<Scalar>::compress(const MultiGrid<dim, Data, Index>& grid)
+{
+    for (auto& channel : channels_)
+    {
+        if (channel.active)
+        {
+            grid.reorder(channel.raw_values, channel.values);
+        }
+    }
+}
+
+template <class Scalar>
+template <size_t dim, class Data, class Index>
+void ScalarChannels<Scalar>::disperse(const MultiGrid<dim, Data, Index>& grid, Scalar rate)
+{
+    if (!grid.isCompressed())
+    {
+        throw std::runtime_error("ScalarChannels::disperse(): The grid has to be compressed!");
+    }
+
+    // Collect the active channels once, so the cell loop only touches their arrays
+    std::vector<Scalar*> active_values;
+    for (auto& channel : channels_)
+    {
+        if (channel.active)
+        {
+            if (channel.values.size() != grid.getNumData())
+            {
+                throw std::runtime_error(
+                    "ScalarChannels::disperse(): The number of values differs from the number of data!");
+            }
+            active_values.push_back(channel.values.data());
+        }
+    }
+
+    if (active_values.empty())
+    {
+        return;
+    }
+
+    // The data bounds of each cell locate it's values, as the channels are in the compressed order
+    using Grid = MultiGrid<dim, Data, Index>;
+    const auto data_begin = grid.getCompressedData().begin();
+    grid.forEachOccupiedCell([&](const typename Grid::CellId&, typename Grid::DataBounds bounds)
+    {
+        const auto num_data = static_cast<size_t>(bounds.end - bounds.begin);
+        if (num_data < 2)
+        {
+            return;
+        }
+
+        const auto begin = static_cast<size_t>(bounds.begin - data_begin);
+        const auto end = begin + num_data;
+        const auto inv_count = Scalar(1) / static_cast<Scalar>(num_data);
+        for (auto* values : active_values)
+        {
+            Scalar sum = 0;
+            for (size_t i = begin; i < end; ++i)
+            {
+                sum += values[i];
+            }
+
+            const auto mean = sum * inv_count;
+            for (size_t i = begin; i < end; ++i)
+            {
+                values[i] += rate * (mean - values[i]);
+            }
+        }
+    });
+}
+
+template <class Scalar>
+void ScalarChannels<Scalar>::checkChannelId(size_t channel_id) const
+{
+    if (channel_id >= channels_.size())
+    {
+        throw std::out_of_range("ScalarChannels: Invalid channel id!");
+    }
+}
+
+} // end namespace dire
@@ -0,0 +1,402 @@
+///
+/// @copyrightblock
+///
+///   NPOSL-3.0 License
+///
+///   Copyright(c) 2021 Mtys Lrnt-Nyeste
+///
+///   Licensed under the Non-Profit Open Software License, version 3.0 (the "License"); you may not use this file except
+///   in compliance with the License. You may obtain a copy of the License at:
+///
+///   https://opensource.org/licenses/NPOSL-3.0
+///
+///   Unless required by applicable law or agreed to in writing, software distributed under the License is distributed
+///   on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for
+///   the specific language governing permissionsand limitations under the License.
+///
+/// @endcopyrightblock
+///
+
+#pragma once
+
+#include "multi_grid.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define DIRE_POSIX_SHM
+#endif
+
+#if defined(DIRE_POSIX_SHM)
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace dire {
+
+namespace detail {
+
+/// @brief The header at the beginning of a shared memory segment holding an exported grid. The arrays follow it at
+///        the given byte offsets from the beginning of the segment.
+template <size_t dim>
+struct SharedGridHeader
+{
+    uint64_t magic;                         ///< "kSharedGridMagic", once the segment is initialized
+    uint64_t num_dims;                      ///< The dimensionality of the grid
+    uint64_t data_size;                     ///< The size of a data in bytes
+    uint64_t index_size;                    ///< The size of an index in bytes
+    uint64_t capacity;                      ///< The size of the segment in bytes
+    std::atomic<uint64_t> sequence;         ///< Odd while a step is being written, incremented twice per step
+    uint64_t step;                          ///< The id of the published step, given by the writer
+    uint64_t grid_size[dim];                ///< The number of cells along each dimension
+    uint64_t num_cells;                     ///< The gross number of cells
+    uint64_t num_data;                      ///< The number of data
+    uint64_t num_data_per_cell_offset;      ///< The offset of the number of data in each cell
+    uint64_t first_data_id_per_cell_offset; ///< The offset of the id of the first data of each cell
+    uint64_t data_offset;                   ///< The offset of the data in the compressed order
+};
+
+constexpr uint64_t kSharedGridMagic = 0x4449524547524944; ///< "DIREGRID"
+
+/// @brief Rounds a byte offset up to the size of a cache line.
+/// @param offset The offset.
+/// @return The aligned offset.
+inline uint64_t alignOffset(uint64_t offset)
+{
+    return (offset + kCacheLineSize - 1) / kCacheLineSize * kCacheLineSize;
+}
+
+/// @brief Throws the last error of a system call.
+/// @param message The description of the failed operation.
+/// @throws std::runtime_error Always.
+[[noreturn]] inline void throwSystemError(const std::string& message)
+{
+    throw std::runtime_error(message + " (" + std::strerror(errno) + ")!");
+}
+
+} // end namespace detail
+
+/// @brief Exports the compressed arrays of a "MultiGrid" into a POSIX shared memory segment, so a separate process
+///        (e.g. an in-situ analysis, which should not be able to crash the solver) can map and consume each published
+///        step in place, through a "SharedGridReader". The steps are guarded by a sequence lock: the writer never
+///        waits for the readers, and the readers detect, if a step was overwritten while they were reading it.
+/// @tparam dim The dimensionality of the grid.
+/// @tparam Data The type of the stored data. Has to be trivially copyable, as it is read by another process.
+/// @tparam Index The unsigned integer type of the cell ids and data ids.
+template <size_t dim, class Data, class Index = size_t>
+class SharedGridExporter
+{
+private:
+
+    static_assert(std::is_trivially_copyable<Data>::value, "Data has to be trivially copyable.");
+    static_assert(alignof(Data) <= detail::kCacheLineSize, "Data can not be aligned beyond a cache line.");
+    static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "The sequence counter has to be lock free to be shared.");
+
+public:
+
+    using Grid = MultiGrid<dim, Data, Index>;
+
+    /// @brief Constructor. Creates the shared memory segment, replacing any existing segment of the same name.
+    /// @param name The name of the segment, starting with a slash (e.g. "/dire_grid").
+    /// @param capacity The size of the segment in bytes, limiting the size of the published grids.
+    /// @throws std::runtime_error If the segment can not be created or mapped, or the capacity can not hold the header.
+    SharedGridExporter(std::string name, size_t capacity);
+
+    /// @brief Destructor. Unmaps and removes the segment. Readers having it mapped keep their mappings.
+    ~SharedGridExporter();
+
+    SharedGridExporter(const SharedGridExporter&) = delete;
+    SharedGridExporter& operator=(const SharedGridExporter&) = delete;
+
+    /// @brief Computes the segment size needed to publish a grid.
+    /// @param grid_size The number of cells along each dimension.
+    /// @param num_data The number of data.
+    /// @return The size in bytes.
+    static size_t computeCapacity(const typename Grid::GridSize& grid_size, size_t num_data);
+
+    /// @brief Copies the compressed arrays of a grid into the segment, overwriting the previous step.
+    /// @param grid The grid.
+    /// @param step The id of the step, passed to the readers.
+    /// @throws std::runtime_error If the grid is not compressed, or does not fit into the segment.
+    void publish(const Grid& grid, uint64_t step);
+
+private:
+
+    using Header = detail::SharedGridHeader<dim>;
+
+    std::string name_;     ///< The name of the segment
+    size_t capacity_;      ///< The size of the segment in bytes
+    unsigned char* begin_; ///< The beginning of the mapped segment
+};
+
+/// @brief Maps a shared memory segment written by a "SharedGridExporter" of the same template arguments, and reads the
+///        published steps in place.
+/// @tparam dim The dimensionality of the grid.
+/// @tparam Data The type of the stored data.
+/// @tparam Index The unsigned integer type of the cell ids and data ids.
+template <size_t dim, class Data, class Index = size_t>
+class SharedGridReader
+{
+public:
+
+    /// @brief The arrays of a published step, pointing into the segment.
+    struct View
+    {
+        uint64_t step;                       ///< The id of the step
+        std::array<Index, dim> grid_size;    ///< The number of cells along each dimension
+        size_t num_cells;                    ///< The gross number of cells
+        size_t num_data;                     ///< The number of data
+        const Index* num_data_per_cell;      ///< The number of data in each cell, indexed by storage id
+        const Index* first_data_id_per_cell; ///< The id of the first data of each cell, indexed by storage id
+        const Data* data;                    ///< The data in the compressed order
+    };
+
+    /// @brief Constructor. Maps an existing segment for reading.
+    /// @param name The name of the segment.
+    /// @throws std::runtime_error If the segment can not be opened or mapped, or it was written with a different
+    ///                            dimensionality, data or index size.
+    explicit SharedGridReader(const std::string& name);
+
+    /// @brief Destructor. Unmaps the segment.
+    ~SharedGridReader();
+
+    SharedGridReader(const SharedGridReader&) = delete;
+    SharedGridReader& operator=(const SharedGridReader&) = delete;
+
+    /// @brief Returns the sequence number of the segment, which changes with each published step. Lets readers poll
+    ///        for new steps cheaply.
+    /// @return The sequence number. Odd, while a step is being written.
+    uint64_t getSequence() const;
+
+    /// @brief Lets a function read the latest published step in place. The writer may overwrite the step meanwhile,
+    ///        so the function has to tolerate inconsistent arrays (e.g. bound all indexing by the sizes of the view),
+    ///        and any result of it has to be discarded, unless the read succeeds.
+    /// @param function Called as "function(view)" with the arrays of the step.
+    /// @return Whether the step stayed unchanged while the function read it. False without calling the function, if
+    ///         nothing was published yet, or a step is being written.
+    template <class Function>
+    bool tryRead(Function&& function) const;
+
+private:
+
+    using Header = detail::SharedGridHeader<dim>;
+
+    size_t capacity_;            ///< The size of the segment in bytes
+    const unsigned char* begin_; ///< The beginning of the mapped segment
+};
+
+//======================================================================================================================
+
+template <size_t dim, class Data, class Index>
+SharedGridExporter<dim, Data, Index>::SharedGridExporter(std::string name, size_t capacity)
+    : name_(std::move(name))
+    , capacity_(capacity)
+    , begin_(nullptr)
+{
+    if (capacity < sizeof(Header))
+    {
+        throw std::runtime_error("SharedGridExporter: The capacity can not hold the header!");
+    }
+
+    shm_unlink(name_.c_str());
+    const auto file = shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (file < 0)
+    {
+        detail::throwSystemError("SharedGridExporter: Creating the shared memory segment failed");
+    }
+
+    void* address = MAP_FAILED;
+    if (ftruncate(file, static_cast<off_t>(capacity)) == 0)
+    {
+        address = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    }
+    const auto error = errno;
+    close(file);
+    if (address == MAP_FAILED)
+    {
+        shm_unlink(name_.c_str());
+        errno = error;
+        detail::throwSystemError("SharedGridExporter: Mapping the shared memory segment failed");
+    }
+
+    // The segment is zero filled, so readers see a zero magic, until the header is complete
+    begin_ = static_cast<unsigned char*>(address);
+    auto* header = new (begin_) Header;
+    header->num_dims = dim;
+    header->data_size = sizeof(Data);
+    header->index_size = sizeof(Index);
+    header->capacity = capacity;
+    header->sequence.store(0, std::memory_order_relaxed);
+    header->step = 0;
+    header->num_cells = 0;
+    header->num_data = 0;
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = detail::kSharedGridMagic;
+}
+
+template <size_t dim, class Data, class Index>
+SharedGridExporter<dim, Data, Index>::~SharedGridExporter()
+{
+    munmap(begin_, capacity_);
+    shm_unlink(name_.c_str());
+}
+
+template <size_t dim, class Data, class Index>
+size_t SharedGridExporter<dim, Data, Index>::computeCapacity(const typename Grid::GridSize& grid_size,
+                                                             size_t num_data)
+{
+    size_t num_cells = 1;
+    for (const auto size : grid_size)
+    {
+        num_cells *= size;
+    }
+
+    auto capacity = detail::alignOffset(sizeof(Header));
+    capacity = detail::alignOffset(capacity + num_cells * sizeof(Index));
+    capacity = detail::alignOffset(capacity + num_cells * sizeof(Index));
+    return static_cast<size_t>(capacity + num_data * sizeof(Data));
+}
+
+template <size_t dim, class Data, class Index>
+void SharedGridExporter<dim, Data, Index>::publish(const Grid& grid, uint64_t step)
+{
+    const auto& data = grid.getCompressedData();
+    const auto& num_data_per_cell = grid.getNumDataPerCell();
+    const auto& first_data_id_per_cell = grid.getFirstDataIdPerCell();
+    const auto num_cells = num_data_per_cell.size();
+    if (computeCapacity(grid.getGridSize(), data.size()) > capacity_)
+    {
+        throw std::runtime_error("SharedGridExporter::publish(): The grid does not fit into the segment!");
+    }
+
+    auto& header = *reinterpret_cast<Header*>(begin_);
+    const auto sequence = header.sequence.load(std::memory_order_relaxed);
+    header.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    header.step = step;
+    for (size_t i = 0; i < dim; ++i)
+    {
+        header.grid_size[i] = grid.getGridSize()[i];
+    }
+    header.num_cells = num_cells;
+    header.num_data = data.size();
+    header.num_data_per_cell_offset = detail::alignOffset(sizeof(Header));
+    header.first_data_id_per_cell_offset = detail::alignOffset(header.num_data_per_cell_offset
+                                                               + num_cells * sizeof(Index));
+    header.data_offset = detail::alignOffset(header.first_data_id_per_cell_offset + num_cells * sizeof(Index));
+    std::memcpy(begin_ + header.num_data_per_cell_offset, num_data_per_cell.data(), num_cells * sizeof(Index));
+    std::memcpy(begin_ + header.first_data_id_per_cell_offset, first_data_id_per_cell.data(),
+                num_cells * sizeof(Index));
+    if (!data.empty())
+    {
+        std::memcpy(begin_ + header.data_offset, data.data(), data.size() * sizeof(Data));
+    }
+
+    header.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+//======================================================================================================================
+
+template <size_t dim, class Data, class Index>
+SharedGridReader<dim, Data, Index>::SharedGridReader(const std::string& name)
+    : capacity_(0)
+    , begin_(nullptr)
+{
+    const auto file = shm_open(name.c_str(), O_RDONLY, 0);
+    if (file < 0)
+    {
+        detail::throwSystemError("SharedGridReader: Opening the shared memory segment failed");
+    }
+
+    struct stat status;
+    void* address = MAP_FAILED;
+    if (fstat(file, &status) == 0 && static_cast<size_t>(status.st_size) >= sizeof(Header))
+    {
+        capacity_ = static_cast<size_t>(status.st_size);
+        address = mmap(nullptr, capacity_, PROT_READ, MAP_SHARED, file, 0);
+    }
+    const auto error = errno;
+    close(file);
+    if (address == MAP_FAILED)
+    {
+        errno = error;
+        detail::throwSystemError("SharedGridReader: Mapping the shared memory segment failed");
+    }
+
+    begin_ = static_cast<const unsigned char*>(address);
+    const auto& header = *reinterpret_cast<const Header*>(begin_);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (header.magic != detail::kSharedGridMagic || header.num_dims != dim || header.data_size != sizeof(Data)
+        || header.index_size != sizeof(Index) || header.capacity > capacity_)
+    {
+        munmap(const_cast<unsigned char*>(begin_), capacity_);
+        throw std::runtime_error("SharedGridReader: The segment does not hold a grid of the expected layout!");
+    }
+}
+
+template <size_t dim, class Data, class Index>
+SharedGridReader<dim, Data, Index>::~SharedGridReader()
+{
+    munmap(const_cast<unsigned char*>(begin_), capacity_);
+}
+
+template <size_t dim, class Data, class Index>
+uint64_t SharedGridReader<dim, Data, Index>::getSequence() const
+{
+    return reinterpret_cast<const Header*>(begin_)->sequence.load(std::memory_order_acquire);
+}
+
+template <size_t dim, class Data, class Index>
+template <class Function>
+bool SharedGridReader<dim, Data, Index>::tryRead(Function&& function) const
+{
+    const auto& header = *reinterpret_cast<const Header*>(begin_);
+    const auto sequence = header.sequence.load(std::memory_order_acquire);
+    if (sequence == 0 || sequence % 2 != 0)
+    {
+        return false;
+    }
+
+    // Offsets torn by a concurrent write could point outside of the segment
+    View view;
+    view.step = header.step;
+    for (size_t i = 0; i < dim; ++i)
+    {
+        view.grid_size[i] = static_cast<Index>(header.grid_size[i]);
+    }
+    view.num_cells = static_cast<size_t>(header.num_cells);
+    view.num_data = static_cast<size_t>(header.num_data);
+    const auto num_data_per_cell_offset = header.num_data_per_cell_offset;
+    const auto first_data_id_per_cell_offset = header.first_data_id_per_cell_offset;
+    const auto data_offset = header.data_offset;
+    if (view.num_cells > capacity_ || view.num_data > capacity_
+        || num_data_per_cell_offset + view.num_cells * sizeof(Index) > capacity_
+        || first_data_id_per_cell_offset + view.num_cells * sizeof(Index) > capacity_
+        || data_offset + view.num_data * sizeof(Data) > capacity_)
+    {
+        return false;
+    }
+
+    view.num_data_per_cell = reinterpret_cast<const Index*>(begin_ + num_data_per_cell_offset);
+    view.first_data_id_per_cell = reinterpret_cast<const Index*>(begin_ + first_data_id_per_cell_offset);
+    view.data = reinterpret_cast<const Data*>(begin_ + data_offset);
+    function(static_cast<const View&>(view));
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return header.sequence.load(std::memory_order_relaxed) == sequence;
+}
+
+} // end namespace dire
+
+#endif
@@ -0,0 +1,456 @@
+///
+/// @copyrightblock
+///
+///   NPOSL-3.0 License
+///
+///   Copyright(c) 2021 Mtys Lrnt-Nyeste
+///
+///   Licensed under the Non-Profit Open Software License, version 3.0 (the "License"); you may not use this file except
+///   in compliance with the License. You may obtain a copy of the License at:
+///
+///   https://opensource.org/licenses/NPOSL-3.0
+///
+///   Unless required by applicable law or agreed to in writing, software distributed under the License is distributed
+///   on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for
+///   the specific language governing permissionsand limitations under the License.
+///
+/// @endcopyrightblock
+///
+
+#pragma once
+
+#include "multi_grid.hpp"
+#include "thread_pool.hpp"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace dire {
+
+/// @brief Publishes the compressed states of a "MultiGrid" as immutable, reference counted snapshots, so reader threads
+///        (e.g. visualization or analysis) can hold the latest state without blocking the writer building the next
+///        one. The snapshots live in a fixed number of slots, each with an atomic count of it's readers, and the
+///        latest slot is published through an atomic index, so neither acquiring nor releasing a snapshot takes a lock
+///        or allocates. A published grid is swapped into a slot no longer held by any reader, so the writer receives
+///        the buffers of a released snapshot, instead of reallocating them.
+///
+///        "publish()" and "getNumRecycledGrids()" have to be called from a single writer thread, "acquire()" may be
+///        called from any thread. The snapshots may outlive the publisher. Coroutines can await the next publication
+///        by "co_await publisher.acquireAsync(pool, snapshot)", without blocking a thread.
+/// @tparam dim The dimensionality of the grid.
+/// @tparam Data The type of the stored data.
+/// @tparam Index The unsigned integer type of the cell ids and data ids.
+template <size_t dim, class Data, class Index = size_t>
+class SnapshotPublisher
+{
+private:
+
+    struct State;
+    struct Slot;
+
+public:
+
+    using Grid = MultiGrid<dim, Data, Index>;
+
+    /// @brief A held snapshot of a published grid, or null. Copying it adds a reader to the snapshot.
+    class Snapshot
+    {
+    public:
+
+        Snapshot() = default;
+        Snapshot(const Snapshot& other);
+        Snapshot(Snapshot&& other) noexcept;
+        Snapshot& operator=(Snapshot other) noexcept;
+        ~Snapshot();
+
+        /// @brief Releases the snapshot, making it null.
+        void reset();
+
+        /// @brief Returns the grid of the snapshot.
+        /// @return The grid, or null.
+        const Grid* get() const;
+
+        const Grid& operator*() const { return *get(); }
+        const Grid* operator->() const { return get(); }
+        explicit operator bool() const { return slot_ != nullptr; }
+
+    private:
+
+        friend class SnapshotPublisher;
+
+        Snapshot(std::shared_ptr<State> state, Slot* slot);
+
+        std::shared_ptr<State> state_; ///< Keeps the slots alive, if the publisher is destroyed first
+        Slot* slot_ = nullptr;         ///< The held slot, or null
+    };
+
+    /// @brief Constructor.
+    /// @param num_slots The number of snapshots existing at once: the latest one, the ones still held by readers, and
+    ///                  the released ones waiting to be reused.
+    /// @throws std::runtime_error If the number of slots is less, than two.
+    explicit SnapshotPublisher(size_t num_slots = kDefaultNumSlots);
+
+    /// @brief Destructor. Resumes the coroutines awaiting a publication with a null snapshot.
+    ~SnapshotPublisher();
+
+    SnapshotPublisher(const SnapshotPublisher&) = delete;
+    SnapshotPublisher& operator=(const SnapshotPublisher&) = delete;
+
+    /// @brief Publishes the compressed state of a grid, replacing the previously published snapshot. The grid receives
+    ///        the buffers of a released snapshot (if any), and is cleared, ready to be filled with the next state.
+    /// @param grid The compressed grid. Keeps it's grid size, prefetch distance, scatter strategy and whether it
+    ///             records the compression permutation.
+    /// @return Whether the grid was published. False, if all slots but the latest one are held by readers, leaving
+    ///         the grid unchanged.
+    /// @throws std::runtime_error If the grid is not compressed.
+    bool publish(Grid& grid);
+
+    /// @brief Returns the latest published snapshot. The snapshot stays valid and unchanged while it is held,
+    ///        regardless of later publications.
+    /// @return The snapshot, or null, if nothing was published yet.
+    Snapshot acquire() const;
+
+#if defined(__cpp_impl_coroutine)
+    /// @brief Awaitable, that resumes the awaiting coroutine with the latest snapshot, once it differs from a given
+    ///        one. The coroutine is resumed on one of the worker threads of the pool by the publication, or right
+    ///        away, if a different snapshot is already published.
+    class AcquireAwaiter
+    {
+    public:
+        AcquireAwaiter(std::shared_ptr<State> state, ThreadPool& pool, Snapshot previous, size_t previous_slot);
+        bool await_ready() const noexcept;
+        bool await_suspend(std::coroutine_handle<> handle);
+        Snapshot await_resume() const;
+
+    private:
+        /// @brief Returns whether the awaiting coroutine can be resumed: a different snapshot is published, or the
+        ///        publisher is destroyed.
+        bool isReady() const noexcept;
+
+        std::shared_ptr<State> state_; ///< The slots
+        ThreadPool& pool_;             ///< The pool resuming the coroutine
+        Snapshot previous_;            ///< The given snapshot, held so it's slot is not published again meanwhile
+        size_t previous_slot_;         ///< The slot of the given snapshot, or "kNoSlot"
+    };
+
+    /// @brief Awaits the publication of a snapshot different from the given one (e.g. the one a reader is done
+    ///        with), then returns the latest snapshot, e.g. "snapshot = co_await publisher.acquireAsync(pool,
+    ///        snapshot);". May be awaited from any thread. The pool has to outlive the awaiting coroutine's suspension.
+    /// @param pool The thread pool, on which the coroutine is resumed by the publication.
+    /// @param previous The snapshot to differ from. If null, any published snapshot is returned.
+    /// @return The awaitable, resulting in the snapshot, or null, if the publisher is destroyed meanwhile.
+    AcquireAwaiter acquireAsync(ThreadPool& pool, Snapshot previous = Snapshot()) const;
+#endif
+
+    /// @brief Returns the number of grids released by the readers, waiting to be reused.
+    /// @return The number of recycled grids.
+    size_t getNumRecycledGrids() const;
+
+    static constexpr size_t kDefaultNumSlots = 8; ///< The default number of slots
+
+private:
+
+    /// @brief A snapshot and the number of it's readers.
+    struct Slot
+    {
+        std::atomic<size_t> num_readers{ 0 }; ///< The number of snapshots holding the slot
+        std::unique_ptr<Grid> grid;           ///< The grid, only changed by the writer while no reader holds the slot
+    };
+
+    /// @brief The slots, shared with the snapshots, which may outlive the publisher.
+    struct State
+    {
+        explicit State(size_t slot_count) : slots(std::make_unique<Slot[]>(slot_count)), num_slots(slot_count) {}
+
+        std::unique_ptr<Slot[]> slots;         ///< The slots
+        size_t num_slots;                      ///< The number of slots
+        std::atomic<size_t> latest{ kNoSlot }; ///< The slot of the latest snapshot, or "kNoSlot"
+        std::atomic<bool> closed{ false };     ///< Whether the publisher is destroyed
+
+#if defined(__cpp_impl_coroutine)
+        /// @brief A coroutine awaiting a publication, and the pool resuming it.
+        struct Waiter
+        {
+            std::coroutine_handle<> handle; ///< The suspended coroutine
+            ThreadPool* pool;               ///< The pool resuming the coroutine
+        };
+
+        std::mutex waiters_mutex;    ///< Guards the waiters against the publications
+        std::vector<Waiter> waiters; ///< The coroutines awaiting a publication
+#endif
+    };
+
+    /// @brief Returns the latest snapshot of the given slots.
+    /// @param state The slots.
+    /// @return The snapshot, or null, if nothing was published yet.
+    static Snapshot acquire(const std::shared_ptr<State>& state);
+
+    /// @brief Resumes the coroutines awaiting a publication on their pools.
+    /// @param state The slots.
+    static void resumeWaiters(State& state);
+
+    static constexpr size_t kNoSlot = static_cast<size_t>(-1); ///< The latest slot before the first publication
+
+    std::shared_ptr<State> state_; ///< The slots
+};
+
+template <size_t dim, class Data, class Index>
+constexpr size_t SnapshotPublisher<dim, Data, Index>::kDefaultNumSlots;
+
+template <size_t dim, class Data, class Index>
+constexpr size_t SnapshotPublisher<dim, Data, Index>::kNoSlot;
+
+//======================================================================================================================
+
+template <size_t dim, class Data, class Index>
+SnapshotPublisher<dim, Data, Index>::Snapshot::Snapshot(const Snapshot& other)
+    : state_(other.state_)
+    , slot_(other.slot_)
+{
+    if (slot_ != nullptr)
+    {
+        slot_->num_readers.fetch_add(1);
+    }
+}
+
+template <size_t dim, class Data, class Index>
+SnapshotPublisher<dim, Data, Index>::Snapshot::Snapshot(Snapshot&& other) noexcept
+    : state_(std::move(other.state_))
+    , slot_(other.slot_)
+{
+    other.slot_ = nullptr;
+}
+
+template <size_t dim, class Data, class Index>
+typename SnapshotPublisher<dim, Data, Index>::Snapshot& SnapshotPublisher<dim, Data, Index>::Snapshot::operator=(
+    Snapshot other) noexcept
+{
+    std::swap(state_, other.state_);
+    std::swap(slot_, other.slot_);
+    return *this;
+}
+
+template <size_t dim, class Data, class Index>
+SnapshotPublisher<dim, Data, Index>::Snapshot::~Snapshot()
+{
+    reset();
+}
+
+template <size_t dim, class Data, class Index>
+void SnapshotPublisher<dim, Data, Index>::Snapshot::reset()
+{
+    if (slot_ != nullptr)
+    {
+        // Releasing the reads of the grid, before the writer may reuse the slot
+        slot_->num_readers.fetch_sub(1);
+        slot_ = nullptr;
+        state_.reset();
+    }
+}
+
+template <size_t dim, class Data, class Index>
+const typename SnapshotPublisher<dim, Data, Index>::Grid* SnapshotPublisher<dim, Data, Index>::Snapshot::get() const
+{
+    return slot_ != nullptr ? slot_->grid.get() : nullptr;
+}
+
+template <size_t dim, class Data, class Index>
+SnapshotPublisher<dim, Data, Index>::Snapshot::Snapshot(std::shared_ptr<State> state, Slot* slot)
+    : state_(std::move(state))
+    , slot_(slot)
+{
+}
+
+template <size_t dim, class Data, class Index>
+SnapshotPublisher<dim, Data, Index>::SnapshotPublisher(size_t num_slots)
+{
+    if (num_slots < 2)
+    {
+        throw std::runtime_error("SnapshotPublisher: The number of slots has to be at least two!");
+    }
+
+    state_ = std::make_shared<State>(num_slots);
+}
+
+template <size_t dim, class Data, class Index>
+SnapshotPublisher<dim, Data, Index>::~SnapshotPublisher()
+{
+    state_->closed.store(true);
+    resumeWaiters(*state_);
+}
+
+template <size_t dim, class Data, class Index>
+bool SnapshotPublisher<dim, Data, Index>::publish(Grid& grid)
+{
+    if (!grid.isCompressed())
+    {
+        throw std::runtime_error("SnapshotPublisher::publish(): The grid has to be compressed!");
+    }
+
+    // Take a slot without readers, preferring one holding a grid of the same size. A reader may still add itself
+    // to the taken slot, but it sees that the slot is not the latest one, and leaves it, until it is published.
+    auto& state = *state_;
+    const auto latest = state.latest.load();
+    Slot* free_slot = nullptr;
+    for (size_t i = 0; i < state.num_slots; ++i)
+    {
+        auto& slot = state.slots[i];
+        if (i == latest || slot.num_readers.load() != 0)
+        {
+            continue;
+        }
+
+        if (free_slot == nullptr || (slot.grid && slot.grid->getGridSize() == grid.getGridSize()))
+        {
+            free_slot = &slot;
+        }
+    }
+    if (free_slot == nullptr)
+    {
+        return false;
+    }
+
+    auto& snapshot_grid = free_slot->grid;
+    if (!snapshot_grid || snapshot_grid->getGridSize() != grid.getGridSize())
+    {
+        snapshot_grid = std::make_unique<Grid>(grid.getGridSize());
+    }
+
+    snapshot_grid->setPrefetchDistance(grid.getPrefetchDistance());
+    snapshot_grid->setScatterStrategy(grid.getScatterStrategy());
+    snapshot_grid->setRecordPermutation(grid.isRecordingPermutation());
+    std::swap(*snapshot_grid, grid);
+    grid.clear();
+
+    state.latest.store(static_cast<size_t>(free_slot - state.slots.get()));
+    resumeWaiters(state);
+    return true;
+}
+
+template <size_t dim, class Data, class Index>
+typename SnapshotPublisher<dim, Data, Index>::Snapshot SnapshotPublisher<dim, Data, Index>::acquire() const
+{
+    return acquire(state_);
+}
+
+#if defined(__cpp_impl_coroutine)
+template <size_t dim, class Data, class Index>
+SnapshotPublisher<dim, Data, Index>::AcquireAwaiter::AcquireAwaiter(std::shared_ptr<State> state, ThreadPool& pool,
+                                                                    Snapshot previous, size_t previous_slot)
+    : state_(std::move(state))
+    , pool_(pool)
+    , previous_(std::move(previous))
+    , previous_slot_(previous_slot)
+{
+}
+
+template <size_t dim, class Data, class Index>
+bool SnapshotPublisher<dim, Data, Index>::AcquireAwaiter::await_ready() const noexcept
+{
+    return isReady();
+}
+
+template <size_t dim, class Data, class Index>
+bool SnapshotPublisher<dim, Data, Index>::AcquireAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    // A publication either precedes the check, or finds the coroutine among the waiters
+    std::lock_guard<std::mutex> lock(state_->waiters_mutex);
+    if (isReady())
+    {
+        return false;
+    }
+    state_->waiters.push_back({ handle, &pool_ });
+    return true;
+}
+
+template <size_t dim, class Data, class Index>
+typename SnapshotPublisher<dim, Data, Index>::Snapshot SnapshotPublisher<dim, Data, Index>::AcquireAwaiter::
+    await_resume() const
+{
+    return state_->closed.load() ? Snapshot() : acquire(state_);
+}
+
+template <size_t dim, class Data, class Index>
+bool SnapshotPublisher<dim, Data, Index>::AcquireAwaiter::isReady() const noexcept
+{
+    const auto latest = state_->latest.load();
+    return state_->closed.load() || (latest != kNoSlot && latest != previous_slot_);
+}
+
+template <size_t dim, class Data, class Index>
+typename SnapshotPublisher<dim, Data, Index>::AcquireAwaiter SnapshotPublisher<dim, Data, Index>::acquireAsync(
+    ThreadPool& pool, Snapshot previous) const
+{
+    const auto previous_slot = previous.slot_ != nullptr ? static_cast<size_t>(previous.slot_ - state_->slots.get())
+                                                          : kNoSlot;
+    return AcquireAwaiter(state_, pool, std::move(previous), previous_slot);
+}
+#endif
+
+template <size_t dim, class Data, class Index>
+typename SnapshotPublisher<dim, Data, Index>::Snapshot SnapshotPublisher<dim, Data, Index>::acquire(
+    const std::shared_ptr<State>& state_ptr)
+{
+    auto& state = *state_ptr;
+    while (true)
+    {
+        const auto latest = state.latest.load();
+        if (latest == kNoSlot)
+        {
+            return Snapshot();
+        }
+
+        // The slot may have been replaced, and taken by the writer, before the reader was added, so it is only held,
+        // if it is still the latest one afterwards. Otherwise retrying with the newly published slot.
+        auto& slot = state.slots[latest];
+        slot.num_readers.fetch_add(1);
+        if (state.latest.load() == latest)
+        {
+            return Snapshot(state_ptr, &slot);
+        }
+        slot.num_readers.fetch_sub(1);
+    }
+}
+
+template <size_t dim, class Data, class Index>
+void SnapshotPublisher<dim, Data, Index>::resumeWaiters(State& state)
+{
+#if defined(__cpp_impl_coroutine)
+    std::vector<typename State::Waiter> waiters;
+    {
+        std::lock_guard<std::mutex> lock(state.waiters_mutex);
+        waiters.swap(state.waiters);
+    }
+
+    for (const auto& waiter : waiters)
+    {
+        const auto handle = waiter.handle;
+        waiter.pool->submit([handle]() { handle.resume(); });
+    }
+#else
+    (void)state;
+#endif
+}
+
+template <size_t dim, class Data, class Index>
+size_t SnapshotPublisher<dim, Data, Index>::getNumRecycledGrids() const
+{
+    const auto& state = *state_;
+    const auto latest = state.latest.load();
+    size_t num_recycled_grids = 0;
+    for (size_t i = 0; i < state.num_slots; ++i)
+    {
+        const auto& slot = state.slots[i];
+        if (i != latest && slot.grid && slot.num_readers.load() == 0)
+        {
+            ++num_recycled_grids;
+        }
+    }
+    return num_recycled_grids;
+}
+
+} // end namespace dire
@@ -0,0 +1,371 @@
+///
+/// @copyrightblock
+///
+///   NPOSL-3.0 License
+///
+///   Copyright(c) 2021 Mtys Lrnt-Nyeste
+///
+///   Licensed under the Non-Profit Open Software License, version 3.0 (the "License"); you may not use this file except
+///   in compliance with the License. You may obtain a copy of the License at:
+///
+///   https://opensource.org/licenses/NPOSL-3.0
+///
+///   Unless required by applicable law or agreed to in writing, software distributed under the License is distributed
+///   on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for
+///   the specific language governing permissionsand limitations under the License.
+///
+/// @endcopyrightblock
+///
+
+#pragma once
+
+#include "multi_grid.hpp"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace dire {
+
+/// @brief A grid holding multiple elements in each cell like "MultiGrid", for domains that are mostly empty (e.g. the
+///        far field of external flows). The grid is tiled into blocks of "block_edge^dim" cells, and the per-cell
+///        arrays are allocated only for the blocks holding data, found through a dense table of the blocks. A cell is
+///        looked up in O(1), and the data of a block is stored contiguously, the cells of the blocks (and the blocks)
+///        following each other in row-major order.
+/// @tparam block_edge The number of cells there are in a block along each dimension.
+/// @tparam Index The unsigned integer type of the cell ids, and of the per-cell counts and data ids.
+template <size_t dim, class Data, size_t block_edge = 8, class Index = size_t>
+class SparseMultiGrid
+{
+private:
+
+    static_assert(dim > 0, "The dimensionality must be greater, than zero!");
+    static_assert(block_edge > 0, "The block edge must be greater, than zero!");
+    static_assert(std::is_default_constructible<Data>::value, "Data has to be default constructible.");
+    static_assert(std::is_integral<Index>::value && std::is_unsigned<Index>::value,
+                  "Index has to be an unsigned integral type.");
+
+public:
+
+    using GridSize = std::array<Index, dim>;
+    using CellId = std::array<Index, dim>;
+    using DataVector = typename MultiGrid<dim, Data, Index>::DataVector;
+    using DataBounds = typename MultiGrid<dim, Data, Index>::DataBounds;
+
+    /// @brief Constructor.
+    /// @param grid_size The number of cells there are in the grid along each dimension.
+    /// @param buff_size The number of data, that can be stored without reallocation.
+    /// @throws std::runtime_error If any of the grid sizes is zero, or the number of cells of the blocks exceeds the
+    ///                            range of "Index".
+    SparseMultiGrid(const GridSize& grid_size, size_t buff_size = 0);
+
+    /// @brief Adds a data to the given cell of the grid. Makes the grid uncompressed.
+    /// @param cell_id The id of the cell.
+    /// @param data The data.
+    /// @throws std::out_of_range If an invalid cell id is provided.
+    void add(const CellId& cell_id, Data&& data);
+
+    /// @brief Clears all buffered data from the grid. Makes the grid uncompressed.
+    void clear();
+
+    /// @brief Converts the grid into a compressed format, allocating the per-cell arrays of the occupied blocks only.
+    /// @throws std::runtime_error If the number of data exceeds the range of "Index".
+    void compress();
+
+    /// @brief Enumerates all data in the given cell. The grid has to be compressed.
+    /// @param cell_id The id of the cell.
+    /// @return The enumerated data represented by it's begin and end iterators. Empty for cells of unallocated blocks.
+    /// @throws std::runtime_error If the grid is not compressed.
+    /// @throws std::out_of_range If an invalid cell id is provided.
+    DataBounds enumerateData(const CellId& cell_id) const;
+
+    /// @brief Visits the cells of the allocated blocks block by block, skipping the empty blocks. The grid has to be
+    ///        compressed.
+    /// @param function Called with the id of each cell of the allocated blocks (inside the grid), and the bounds of
+    ///                 the data stored in it.
+    /// @throws std::runtime_error If the grid is not compressed.
+    template <class Function>
+    void traverseBlocks(Function&& function) const;
+
+    /// @brief Returns the number of cells there are in the grid along each dimension.
+    /// @return The grid size.
+    const GridSize& getGridSize() const;
+
+    /// @brief Returns the number of data added to the grid since the last clearing.
+    /// @return The number of data.
+    size_t getNumData() const;
+
+    /// @brief Returns the number of blocks, whose per-cell arrays are allocated, as of the last compression.
+    /// @return The number of allocated blocks.
+    size_t getNumAllocatedBlocks() const;
+
+    static constexpr size_t kBlockVolume = detail::power(block_edge, dim); ///< The number of cells in a block
+
+private:
+
+    /// @brief Linearizes the id of the block containing a cell, and the id of the cell inside the block.
+    /// @param cell_id The cell id.
+    /// @param block_storage_id Receives the storage id of the block.
+    /// @param local_id Receives the storage id of the cell inside the block.
+    void linearize(const CellId& cell_id, size_t& block_storage_id, size_t& local_id) const;
+
+    static constexpr Index kNoBlock = std::numeric_limits<Index>::max(); ///< The block id of unallocated blocks
+
+    GridSize grid_size_;                    ///< The number of cells there are in the grid along each dimension
+    GridSize block_grid_size_;              ///< The number of blocks there are along each dimension
+    size_t num_blocks_;                     ///< The gross number of blocks
+    bool compressed_;                       ///< Whether the stored data is compressed
+    std::vector<Data> raw_data_;            ///< The data buffered before compression
+    std::vector<CellId> raw_cell_ids_;      ///< The cell ids of the data buffered before compression
+    std::vector<Index> block_ids_;          ///< The id of the allocated block of each block, or "kNoBlock"
+    std::vector<size_t> allocated_blocks_;  ///< The storage id of each allocated block
+    DataVector data_;                       ///< The stored data in a compressed format
+    std::vector<Index> num_data_per_cell_;  ///< The number of data in each cell of the allocated blocks
+    std::vector<Index> first_data_ids_;     ///< The id of the first data of each cell of the allocated blocks
+    std::vector<Index> sparse_ids_buff_;    ///< Buffer for the index of the cell of each raw data in the blocks
+};
+
+template <size_t dim, class Data, size_t block_edge, class Index>
+constexpr size_t SparseMultiGrid<dim, Data, block_edge, Index>::kBlockVolume;
+
+template <size_t dim, class Data, size_t block_edge, class Index>
+constexpr Index SparseMultiGrid<dim, Data, block_edge, Index>::kNoBlock;
+
+//======================================================================================================================
+
+template <size_t dim, class Data, size_t block_edge, class Index>
+SparseMultiGrid<dim, Data, block_edge, Index>::SparseMultiGrid(const GridSize& grid_size, size_t buff_size)
+    : grid_size_(grid_size)
+    , num_blocks_(1)
+    , compressed_(false)
+{
+    for (size_t i = 0; i < dim; ++i)
+    {
+        if (grid_size_[i] == 0)
+        {
+            throw std::runtime_error("All grid sizes have to be greater, than zero!");
+        }
+
+        block_grid_size_[i] = static_cast<Index>((grid_size_[i] + block_edge - 1) / block_edge);
+        num_blocks_ *= block_grid_size_[i];
+    }
+
+    if (num_blocks_ * kBlockVolume > std::numeric_limits<Index>::max())
+    {
+        throw std::runtime_error("The number of cells exceeds the range of the index type!");
+    }
+
+    raw_data_.reserve(buff_size);
+    raw_cell_ids_.reserve(buff_size);
+    data_.reserve(buff_size);
+    block_ids_.resize(num_blocks_, kNoBlock);
+}
+
+template <size_t dim, class Data, size_t block_edge, class Index>
+void SparseMultiGrid<dim, Data, block_edge, Index>::add(const CellId& cell_id, Data&& data)
+{
+    for (size_t i = 0; i < dim; ++i)
+    {
+        if (cell_id[i] >= grid_size_[i])
+        {
+            throw std::out_of_range("SparseMultiGrid::add(): Invalid cell id!");
+        }
+    }
+
+    compressed_ = false;
+    raw_data_.push_back(std::move(data));
+    raw_cell_ids_.push_back(cell_id);
+}
+
+template <size_t dim, class Data, size_t block_edge, class Index>
+void SparseMultiGrid<dim, Data, block_edge, Index>::clear()
+{
+    compressed_ = false;
+    raw_data_.clear();
+    raw_cell_ids_.clear();
+}
+
+template <size_t dim, class Data, size_t block_edge, class Index>
+void SparseMultiGrid<dim, Data, block_edge, Index>::compress()
+{
+    if (compressed_)
+    {
+        return;
+    }
+
+    const auto num_raw_data = raw_data_.size();
+    if (num_raw_data > std::numeric_limits<Index>::max())
+    {
+        throw std::runtime_error(
+            "SparseMultiGrid::compress(): The number of data exceeds the range of the index type!");
+    }
+
+    // Mark the occupied blocks, remembering the block and local ids of the data
+    std::fill(block_ids_.begin(), block_ids_.end(), kNoBlock);
+    sparse_ids_buff_.resize(2 * num_raw_data);
+    for (size_t i = 0; i < num_raw_data; ++i)
+    {
+        size_t block_storage_id;
+        size_t local_id;
+        linearize(raw_cell_ids_[i], block_storage_id, local_id);
+        block_ids_[block_storage_id] = 0;
+        sparse_ids_buff_[2 * i] = static_cast<Index>(block_storage_id);
+        sparse_ids_buff_[2 * i + 1] = static_cast<Index>(local_id);
+    }
+
+    // Allocate the occupied blocks in storage order
+    allocated_blocks_.clear();
+    for (size_t i = 0; i < num_blocks_; ++i)
+    {
+        if (block_ids_[i] != kNoBlock)
+        {
+            block_ids_[i] = static_cast<Index>(allocated_blocks_.size());
+            allocated_blocks_.push_back(i);
+        }
+    }
+
+    // Count the data of the cells of the allocated blocks, and compute their first data ids
+    const auto num_sparse_cells = allocated_blocks_.size() * kBlockVolume;
+    num_data_per_cell_.assign(num_sparse_cells, 0);
+    for (size_t i = 0; i < num_raw_data; ++i)
+    {
+        auto& sparse_id = sparse_ids_buff_[2 * i];
+        sparse_id = static_cast<Index>(block_ids_[sparse_id] * kBlockVolume + sparse_ids_buff_[2 * i + 1]);
+        ++num_data_per_cell_[sparse_id];
+    }
+
+    first_data_ids_.resize(num_sparse_cells);
+    detail::exclusiveScan(num_data_per_cell_.data(), first_data_ids_.data(), num_sparse_cells);
+
+    // Write the compressed data, using the local ids' slots as the next data ids
+    data_.resize(num_raw_data);
+    for (size_t i = 0; i < num_raw_data; ++i)
+    {
+        const auto sparse_id = sparse_ids_buff_[2 * i];
+        const auto next_data_id = first_data_ids_[sparse_id]++;
+        data_[next_data_id] = raw_data_[i];
+    }
+
+    // Restore the first data ids, that were advanced past the data of their cells
+    for (size_t i = 0; i < num_sparse_cells; ++i)
+    {
+        first_data_ids_[i] = static_cast<Index>(first_data_ids_[i] - num_data_per_cell_[i]);
+    }
+
+    compressed_ = true;
+}
+
+template <size_t dim, class Data, size_t block_edge, class Index>
+typename SparseMultiGrid<dim, Data, block_edge, Index>::DataBounds
+SparseMultiGrid<dim, Data, block_edge, Index>::enumerateData(const CellId& cell_id) const
+{
+    if (!compressed_)
+    {
+        throw std::runtime_error("SparseMultiGrid::enumerateData(): The grid has to be compressed!");
+    }
+
+    for (size_t i = 0; i < dim; ++i)
+    {
+        if (cell_id[i] >= grid_size_[i])
+        {
+            throw std::out_of_range("SparseMultiGrid::enumerateData(): Invalid cell id!");
+        }
+    }
+
+    size_t block_storage_id;
+    size_t local_id;
+    linearize(cell_id, block_storage_id, local_id);
+    const auto block_id = block_ids_[block_storage_id];
+    if (block_id == kNoBlock)
+    {
+        return { data_.end(), data_.end() };
+    }
+
+    const auto sparse_id = block_id * kBlockVolume + local_id;
+    const auto begin_it = data_.begin() + first_data_ids_[sparse_id];
+    return { begin_it, begin_it + num_data_per_cell_[sparse_id] };
+}
+
+template <size_t dim, class Data, size_t block_edge, class Index>
+template <class Function>
+void SparseMultiGrid<dim, Data, block_edge, Index>::traverseBlocks(Function&& function) const
+{
+    if (!compressed_)
+    {
+        throw std::runtime_error("SparseMultiGrid::traverseBlocks(): The grid has to be compressed!");
+    }
+
+    for (size_t block_id = 0; block_id < allocated_blocks_.size(); ++block_id)
+    {
+        // The first cell of the block
+        CellId block_origin;
+        auto block_storage_id = allocated_blocks_[block_id];
+        for (size_t i = 0; i < dim; ++i)
+        {
+            block_origin[i] = static_cast<Index>(block_storage_id % block_grid_size_[i] * block_edge);
+            block_storage_id /= block_grid_size_[i];
+        }
+
+        for (size_t local_id = 0; local_id < kBlockVolume; ++local_id)
+        {
+            CellId cell_id;
+            bool inside = true;
+            auto remainder = local_id;
+            for (size_t i = 0; i < dim; ++i)
+            {
+                cell_id[i] = static_cast<Index>(block_origin[i] + remainder % block_edge);
+                remainder /= block_edge;
+                inside = inside && cell_id[i] < grid_size_[i];
+            }
+
+            if (inside)
+            {
+                const auto sparse_id = block_id * kBlockVolume + local_id;
+                const auto begin_it = data_.begin() + first_data_ids_[sparse_id];
+                function(static_cast<const CellId&>(cell_id),
+                         DataBounds{ begin_it, begin_it + num_data_per_cell_[sparse_id] });
+            }
+        }
+    }
+}
+
+template <size_t dim, class Data, size_t block_edge, class Index>
+const typename SparseMultiGrid<dim, Data, block_edge, Index>::GridSize&
+SparseMultiGrid<dim, Data, block_edge, Index>::getGridSize() const
+{
+    return grid_size_;
+}
+
+template <size_t dim, class Data, size_t block_edge, class Index>
+size_t SparseMultiGrid<dim, Data, block_edge, Index>::getNumData() const
+{
+    return raw_data_.size();
+}
+
+template <size_t dim, class Data, size_t block_edge, class Index>
+size_t SparseMultiGrid<dim, Data, block_edge, Index>::getNumAllocatedBlocks() const
+{
+    return allocated_blocks_.size();
+}
+
+template <size_t dim, class Data, size_t block_edge, class Index>
+void SparseMultiGrid<dim, Data, block_edge, Index>::linearize(const CellId& cell_id, size_t& block_storage_id,
+                                                              size_t& local_id) const
+{
+    block_storage_id = 0;
+    local_id = 0;
+    size_t block_mult = 1;
+    size_t local_mult = 1;
+    for (size_t i = 0; i < dim; ++i)
+    {
+        block_storage_id += cell_id[i] / block_edge * block_mult;
+        local_id += cell_id[i] % block_edge * local_mult;
+        block_mult *= block_grid_size_[i];
+        local_mult *= block_edge;
+    }
+}
+
+} // end namespace dire
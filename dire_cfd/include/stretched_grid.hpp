@@ -0,0 +1,274 @@
+///
+/// @copyrightblock
+///
+///   NPOSL-3.0 License
+///
+///   Copyright(c) 2021 Mtys Lrnt-Nyeste
+///
+///   Licensed under the Non-Profit Open Software License, version 3.0 (the "License"); you may not use this file except
+///   in compliance with the License. You may obtain a copy of the License at:
+///
+///   https://opensource.org/licenses/NPOSL-3.0
+///
+///   Unless required by applicable law or agreed to in writing, software distributed under the License is distributed
+///   on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for
+///   the specific language governing permissionsand limitations under the License.
+///
+/// @endcopyrightblock
+///
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace dire {
+
+/// @brief Maps positions into the cells of a non-uniform (stretched) rectilinear grid, e.g. one refined towards the
+///        walls to resolve a boundary layer, so nodes can be binned into a "MultiGrid" of the same size. Each axis is
+///        described by the coordinates of it's cell edges. Instead of a binary search over the edges per node, each
+///        axis holds a lookup table over a uniform subdivision of it's extent, not coarser, than the smallest cell of
+///        the axis. A uniform sub-interval thus overlaps at most two cells, and the cell of a coordinate is found from
+///        the table entry of it's sub-interval, corrected by a comparison to the next edge.
+/// @tparam dim The dimensionality of the grid.
+/// @tparam Real The floating point type of the coordinates.
+/// @tparam Index The unsigned integer type of the cell ids, matching the "MultiGrid" the nodes are binned into.
+template <size_t dim, class Real = double, class Index = size_t>
+class StretchedGrid
+{
+private:
+
+    static_assert(std::is_floating_point<Real>::value, "Real has to be a floating point type.");
+
+public:
+
+    using GridSize = std::array<Index, dim>;
+    using CellId = std::array<Index, dim>;
+    using Position = std::array<Real, dim>;
+    using Edges = std::array<std::vector<Real>, dim>;
+
+    /// @brief Constructor.
+    /// @param edges The coordinates of the cell edges along each axis, strictly increasing, at least two per axis.
+    /// @param lookup_refinement The number of lookup table entries spanning the smallest cell of an axis.
+    /// @throws std::runtime_error If an axis has less, than two edges, it's edges are not strictly increasing, the
+    ///                            lookup refinement is zero, or a lookup table would have more, than "kMaxTableSize"
+    ///                            entries.
+    StretchedGrid(Edges edges, size_t lookup_refinement = kDefaultLookupRefinement);
+
+    /// @brief Creates the edges of an axis, whose cells grow geometrically from it's beginning.
+    /// @param begin The coordinate of the first edge.
+    /// @param end The coordinate of the last edge.
+    /// @param num_cells The number of cells.
+    /// @param growth_ratio The ratio of the sizes of consecutive cells.
+    /// @return The coordinates of the edges.
+    /// @throws std::runtime_error If the number of cells is zero, the growth ratio is not positive, or the end does not
+    ///                            follow the beginning.
+    static std::vector<Real> geometricEdges(Real begin, Real end, size_t num_cells, Real growth_ratio);
+
+    /// @brief Returns the number of cells along each dimension.
+    /// @return The grid size.
+    const GridSize& getGridSize() const;
+
+    /// @brief Returns the coordinates of the cell edges along an axis.
+    /// @param axis The axis.
+    /// @return The coordinates of the edges.
+    const std::vector<Real>& getEdges(size_t axis) const;
+
+    /// @brief Finds the cell containing a position. Positions on the last edge of an axis belong to it's last cell.
+    /// @param position The position.
+    /// @return The id of the cell.
+    /// @throws std::out_of_range If the position is outside of the grid.
+    CellId findCell(const Position& position) const;
+
+    /// @brief Finds the cells containing multiple positions.
+    /// @param positions The positions.
+    /// @param cell_ids The output cell ids.
+    /// @param count The number of positions.
+    /// @throws std::out_of_range If a position is outside of the grid. The cell ids before it are written.
+    void findCells(const Position* positions, CellId* cell_ids, size_t count) const;
+
+    static constexpr size_t kDefaultLookupRefinement = 2; ///< The default number of entries per smallest cell
+    static constexpr size_t kMaxTableSize = 1 << 24;      ///< The maximal number of entries of a lookup table
+
+private:
+
+    /// @brief Finds the cell containing a coordinate along an axis.
+    /// @param axis The axis.
+    /// @param x The coordinate.
+    /// @return The id of the cell along the axis.
+    /// @throws std::out_of_range If the coordinate is outside of the axis.
+    Index findCell(size_t axis, Real x) const;
+
+    /// @brief The lookup table of an axis.
+    struct Axis
+    {
+        std::vector<Real> edges;   ///< The coordinates of the cell edges
+        std::vector<Index> lookup; ///< The cell containing the beginning of each uniform sub-interval
+        Real inv_step;             ///< The reciprocal of the length of a uniform sub-interval
+    };
+
+    GridSize grid_size_;         ///< The number of cells along each dimension
+    std::array<Axis, dim> axes_; ///< The lookup tables of the axes
+};
+
+template <size_t dim, class Real, class Index>
+constexpr size_t StretchedGrid<dim, Real, Index>::kDefaultLookupRefinement;
+
+template <size_t dim, class Real, class Index>
+constexpr size_t StretchedGrid<dim, Real, Index>::kMaxTableSize;
+
+//======================================================================================================================
+
+template <size_t dim, class Real, class Index>
+StretchedGrid<dim, Real, Index>::StretchedGrid(Edges edges, size_t lookup_refinement)
+{
+    if (lookup_refinement == 0)
+    {
+        throw std::runtime_error("The lookup refinement has to be greater, than zero!");
+    }
+
+    for (size_t i = 0; i < dim; ++i)
+    {
+        auto& axis = axes_[i];
+        axis.edges = std::move(edges[i]);
+        const auto& axis_edges = axis.edges;
+        if (axis_edges.size() < 2)
+        {
+            throw std::runtime_error("StretchedGrid: Each axis has to have at least two edges!");
+        }
+        if (axis_edges.size() - 1 > std::numeric_limits<Index>::max())
+        {
+            throw std::runtime_error("StretchedGrid: The number of cells exceeds the index type!");
+        }
+
+        auto min_cell_size = std::numeric_limits<Real>::infinity();
+        for (size_t j = 1; j < axis_edges.size(); ++j)
+        {
+            if (!(axis_edges[j] > axis_edges[j - 1]))
+            {
+                throw std::runtime_error("StretchedGrid: The edges have to be strictly increasing!");
+            }
+            min_cell_size = std::min(min_cell_size, axis_edges[j] - axis_edges[j - 1]);
+        }
+
+        const auto length = axis_edges.back() - axis_edges.front();
+        const auto table_size = std::ceil(static_cast<double>(length / min_cell_size)) * double(lookup_refinement);
+        if (!(table_size <= static_cast<double>(kMaxTableSize)))
+        {
+            throw std::runtime_error("StretchedGrid: The stretching requires a too large lookup table!");
+        }
+
+        const auto num_entries = std::max<size_t>(static_cast<size_t>(table_size), 1);
+        const auto step = length / static_cast<Real>(num_entries);
+        axis.inv_step = Real(1) / step;
+        axis.lookup.resize(num_entries);
+        size_t cell = 0;
+        for (size_t j = 0; j < num_entries; ++j)
+        {
+            const auto x = axis_edges.front() + static_cast<Real>(j) * step;
+            while (cell + 2 < axis_edges.size() && x >= axis_edges[cell + 1])
+            {
+                ++cell;
+            }
+            axis.lookup[j] = static_cast<Index>(cell);
+        }
+
+        grid_size_[i] = static_cast<Index>(axis_edges.size() - 1);
+    }
+}
+
+template <size_t dim, class Real, class Index>
+std::vector<Real> StretchedGrid<dim, Real, Index>::geometricEdges(Real begin, Real end, size_t num_cells,
+                                                                  Real growth_ratio)
+{
+    if (num_cells == 0 || !(growth_ratio > 0) || !(end > begin))
+    {
+        throw std::runtime_error("StretchedGrid::geometricEdges(): Invalid parameters!");
+    }
+
+    // The sizes of the cells are "first, first * q, first * q^2, ...", summing to the length of the axis
+    std::vector<Real> edges(num_cells + 1);
+    Real weight = 0;
+    Real size = 1;
+    for (size_t i = 0; i < num_cells; ++i)
+    {
+        weight += size;
+        size *= growth_ratio;
+    }
+
+    const auto first_size = (end - begin) / weight;
+    edges.front() = begin;
+    size = first_size;
+    for (size_t i = 1; i < num_cells; ++i)
+    {
+        edges[i] = edges[i - 1] + size;
+        size *= growth_ratio;
+    }
+    edges.back() = end;
+    return edges;
+}
+
+template <size_t dim, class Real, class Index>
+const typename StretchedGrid<dim, Real, Index>::GridSize& StretchedGrid<dim, Real, Index>::getGridSize() const
+{
+    return grid_size_;
+}
+
+template <size_t dim, class Real, class Index>
+const std::vector<Real>& StretchedGrid<dim, Real, Index>::getEdges(size_t axis) const
+{
+    return axes_.at(axis).edges;
+}
+
+template <size_t dim, class Real, class Index>
+typename StretchedGrid<dim, Real, Index>::CellId StretchedGrid<dim, Real, Index>::findCell(
+    const Position& position) const
+{
+    CellId cell_id;
+    for (size_t i = 0; i < dim; ++i)
+    {
+        cell_id[i] = findCell(i, position[i]);
+    }
+    return cell_id;
+}
+
+template <size_t dim, class Real, class Index>
+void StretchedGrid<dim, Real, Index>::findCells(const Position* positions, CellId* cell_ids, size_t count) const
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        cell_ids[i] = findCell(positions[i]);
+    }
+}
+
+template <size_t dim, class Real, class Index>
+Index StretchedGrid<dim, Real, Index>::findCell(size_t axis, Real x) const
+{
+    const auto& edges = axes_[axis].edges;
+    const auto& lookup = axes_[axis].lookup;
+    if (!(x >= edges.front() && x <= edges.back()))
+    {
+        throw std::out_of_range("StretchedGrid::findCell(): The position is outside of the grid!");
+    }
+
+    const auto entry = std::min(static_cast<size_t>((x - edges.front()) * axes_[axis].inv_step), lookup.size() - 1);
+    size_t cell = lookup[entry];
+
+    // The sub-interval overlaps at most two cells, the loops only iterate more on rounding errors of the entry
+    while (cell + 2 < edges.size() && x >= edges[cell + 1])
+    {
+        ++cell;
+    }
+    while (x < edges[cell])
+    {
+        --cell;
+    }
+    return static_cast<Index>(cell);
+}
+
+} // end namespace dire
@@ -0,0 +1,225 @@
+///
+/// @copyrightblock
+///
+///   NPOSL-3.0 License
+///
+///   Copyright(c) 2021 Mtys Lrnt-Nyeste
+///
+///   Licensed under the Non-Profit Open Software License, version 3.0 (the "License"); you may not use this file except
+///   in compliance with the License. You may obtain a copy of the License at:
+///
+///   https://opensource.org/licenses/NPOSL-3.0
+///
+///   Unless required by applicable law or agreed to in writing, software distributed under the License is distributed
+///   on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for
+///   the specific language governing permissionsand limitations under the License.
+///
+/// @endcopyrightblock
+///
+
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__cpp_impl_coroutine)
+#include <coroutine>
+#endif
+
+namespace dire {
+
+/// @brief A fixed size pool of worker threads. The submitted tasks are started in submission order, but with more, than
+///        one worker thread, they run concurrently, and may finish in any order.
+class ThreadPool
+{
+public:
+
+    /// @brief Constructor.
+    /// @param num_threads The number of worker threads. If zero, the number of hardware threads is used.
+    explicit ThreadPool(size_t num_threads = 0);
+
+    /// @brief Destructor. Finishes all submitted tasks before joining the worker threads.
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /// @brief Returns the number of worker threads.
+    /// @return The number of worker threads.
+    size_t getNumThreads() const;
+
+    /// @brief Submits a task to be executed by one of the worker threads.
+    /// @param function The task, callable without arguments.
+    /// @return The future holding the result (or the exception) of the task.
+    template <class Function>
+    std::future<decltype(std::declval<Function&>()())> submit(Function&& function);
+
+    /// @brief Splits a range of indices into contiguous chunks, and processes them on the worker threads. Returns after
+    ///        all chunks are processed, rethrowing the first exception thrown by them. Must not be called from a worker
+    ///        thread of the same pool.
+    /// @param begin The first index.
+    /// @param end The index past the last index.
+    /// @param function Called as "function(chunk_begin, chunk_end)" for each chunk.
+    template <class Function>
+    void parallelFor(size_t begin, size_t end, Function&& function);
+
+#if defined(__cpp_impl_coroutine)
+    /// @brief Awaitable, that resumes the awaiting coroutine on one of the worker threads.
+    class ScheduleAwaiter
+    {
+    public:
+        explicit ScheduleAwaiter(ThreadPool& pool) : pool_(pool) {}
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) { pool_.post([handle]() { handle.resume(); }); }
+        void await_resume() const noexcept {}
+
+    private:
+        ThreadPool& pool_; ///< The pool resuming the coroutine
+    };
+
+    /// @brief Moves the execution of the calling coroutine to the pool, e.g. "co_await pool.schedule();".
+    /// @return The awaitable.
+    ScheduleAwaiter schedule();
+#endif
+
+private:
+
+    /// @brief Queues a task for the worker threads.
+    /// @param task The task.
+    void post(std::function<void()> task);
+
+    /// @brief The loop run by each of the worker threads.
+    void work();
+
+    std::vector<std::thread> threads_;        ///< The worker threads
+    std::queue<std::function<void()>> tasks_; ///< The tasks waiting for execution
+    std::mutex mutex_;                        ///< Guards the task queue and the stopping flag
+    std::condition_variable condition_;       ///< Signals new tasks and stopping to the worker threads
+    bool stopping_;                           ///< Whether the pool is being destroyed
+};
+
+//======================================================================================================================
+
+inline ThreadPool::ThreadPool(size_t num_threads)
+    : stopping_(false)
+{
+    if (num_threads == 0)
+    {
+        num_threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }
+
+    threads_.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; ++i)
+    {
+        threads_.emplace_back([this]() { work(); });
+    }
+}
+
+inline ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    condition_.notify_all();
+
+    for (auto& thread : threads_)
+    {
+        thread.join();
+    }
+}
+
+inline size_t ThreadPool::getNumThreads() const
+{
+    return threads_.size();
+}
+
+template <class Function>
+std::future<decltype(std::declval<Function&>()())> ThreadPool::submit(Function&& function)
+{
+    using Result = decltype(std::declval<Function&>()());
+
+    // "std::function" requires a copyable target, while "std::packaged_task" is move only
+    auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Function>(function));
+    auto future = task->get_future();
+    post([task]() { (*task)(); });
+    return future;
+}
+
+template <class Function>
+void ThreadPool::parallelFor(size_t begin, size_t end, Function&& function)
+{
+    if (begin >= end)
+    {
+        return;
+    }
+
+    // A few chunks per thread balance uneven chunks, without flooding the queue
+    const auto num_indices = end - begin;
+    const auto num_chunks = std::min(num_indices, 4 * threads_.size());
+    const auto chunk_size = (num_indices + num_chunks - 1) / num_chunks;
+
+    std::vector<std::future<void>> futures;
+    futures.reserve(num_chunks);
+    for (size_t chunk_begin = begin; chunk_begin < end; chunk_begin += chunk_size)
+    {
+        const auto chunk_end = std::min(chunk_begin + chunk_size, end);
+        futures.push_back(submit([&function, chunk_begin, chunk_end]() { function(chunk_begin, chunk_end); }));
+    }
+
+    // Wait for all chunks before rethrowing the first failure, as the chunks reference the function
+    for (auto& future : futures)
+    {
+        future.wait();
+    }
+    for (auto& future : futures)
+    {
+        future.get();
+    }
+}
+
+#if defined(__cpp_impl_coroutine)
+inline ThreadPool::ScheduleAwaiter ThreadPool::schedule()
+{
+    return ScheduleAwaiter(*this);
+}
+#endif
+
+inline void ThreadPool::post(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push(std::move(task));
+    }
+    condition_.notify_one();
+}
+
+inline void ThreadPool::work()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+            if (tasks_.empty())
+            {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop();
+        }
+        task();
+    }
+}
+
+} // end namespace dire
@@ -0,0 +1,290 @@
+///
+/// @copyrightblock
+///
+///   NPOSL-3.0 License
+///
+///   Copyright(c) 2021 Mtys Lrnt-Nyeste
+///
+///   Licensed under the Non-Profit Open Software License, version 3.0 (the "License"); you may not use this file except
+///   in compliance with the License. You may obtain a copy of the License at:
+///
+///   https://opensource.org/licenses/NPOSL-3.0
+///
+///   Unless required by applicable law or agreed to in writing, software distributed under the License is distributed
+///   on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for
+///   the specific language governing permissionsand limitations under the License.
+///
+/// @endcopyrightblock
+///
+
+#include "dire_cfd_c.h"
+#include "multi_grid.hpp"
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+/// @brief The type erased grid behind a handle.
+struct dire_grid
+{
+    virtual ~dire_grid() = default;
+
+    virtual size_t getDim() const = 0;
+    virtual size_t getNumFields() const = 0;
+    virtual void add(const size_t* cell_id, const double* fields) = 0;
+    virtual void clear() = 0;
+    virtual void compress() = 0;
+    virtual bool isCompressed() const = 0;
+    virtual dire_grid_view getView() const = 0;
+};
+
+namespace {
+
+thread_local std::string last_error; ///< The message of the last error on the thread
+
+/// @brief A grid of the given dimensionality, whose payload is a fixed number of doubles.
+template <size_t dim, size_t num_fields>
+class Grid final : public dire_grid
+{
+public:
+
+    using Payload = std::array<double, num_fields>;
+    using MultiGrid = dire::MultiGrid<dim, Payload>;
+
+    static_assert(sizeof(Payload) == num_fields * sizeof(double), "The payload has to be a packed array of doubles.");
+
+    Grid(const size_t* grid_size, size_t buff_size) : grid_(toArray(grid_size), buff_size) {}
+
+    size_t getDim() const override { return dim; }
+    size_t getNumFields() const override { return num_fields; }
+
+    void add(const size_t* cell_id, const double* fields) override
+    {
+        Payload payload;
+        std::copy(fields, fields + num_fields, payload.begin());
+        grid_.add(toArray(cell_id), std::move(payload));
+    }
+
+    void clear() override { grid_.clear(); }
+    void compress() override { grid_.compress(); }
+    bool isCompressed() const override { return grid_.isCompressed(); }
+
+    dire_grid_view getView() const override
+    {
+        const auto& data = grid_.getCompressedData();
+        const auto& num_data_per_cell = grid_.getNumDataPerCell();
+
+        dire_grid_view view;
+        view.num_cells = num_data_per_cell.size();
+        view.num_data = data.size();
+        view.num_fields = num_fields;
+        view.num_data_per_cell = num_data_per_cell.data();
+        view.first_data_id_per_cell = grid_.getFirstDataIdPerCell().data();
+        view.data = data.empty() ? nullptr : data.front().data();
+        return view;
+    }
+
+private:
+
+    static typename MultiGrid::CellId toArray(const size_t* values)
+    {
+        typename MultiGrid::CellId array;
+        std::copy(values, values + dim, array.begin());
+        return array;
+    }
+
+    MultiGrid grid_; ///< The wrapped grid
+};
+
+/// @brief Creates the grid instantiation matching a number of fields at runtime, trying "num_fields" and above.
+template <size_t dim, size_t num_fields>
+struct GridFactory
+{
+    static dire_grid* create(const size_t* grid_size, size_t requested_num_fields, size_t buff_size)
+    {
+        if (requested_num_fields == num_fields)
+        {
+            return new Grid<dim, num_fields>(grid_size, buff_size);
+        }
+        return GridFactory<dim, num_fields + 1>::create(grid_size, requested_num_fields, buff_size);
+    }
+};
+
+template <size_t dim>
+struct GridFactory<dim, DIRE_MAX_NUM_FIELDS + 1>
+{
+    static dire_grid* create(const size_t*, size_t, size_t)
+    {
+        throw std::invalid_argument("dire_grid_create(): Unsupported number of fields!");
+    }
+};
+
+/// @brief Calls a function, converting the exceptions thrown by it into a status, and storing their messages.
+/// @param function The function.
+/// @return The status of the call.
+template <class Function>
+dire_status guard(Function&& function)
+{
+    try
+    {
+        function();
+        return DIRE_OK;
+    }
+    catch (const std::invalid_argument& e)
+    {
+        last_error = e.what();
+        return DIRE_INVALID_ARGUMENT;
+    }
+    catch (const std::out_of_range& e)
+    {
+        last_error = e.what();
+        return DIRE_OUT_OF_RANGE;
+    }
+    catch (const std::bad_alloc&)
+    {
+        last_error = "Out of memory!";
+        return DIRE_OUT_OF_MEMORY;
+    }
+    catch (const std::exception& e)
+    {
+        last_error = e.what();
+        return DIRE_ERROR;
+    }
+    catch (...)
+    {
+        last_error = "Unknown error!";
+        return DIRE_ERROR;
+    }
+}
+
+/// @brief Checks the pointer arguments of a call.
+/// @throws std::invalid_argument If any of the pointers is null.
+template <class... Pointers>
+void checkNotNull(const char* function_name, const Pointers*... pointers)
+{
+    const bool not_null[] = { (pointers != nullptr)... };
+    for (const auto value : not_null)
+    {
+        if (!value)
+        {
+            throw std::invalid_argument(std::string(function_name) + ": Null pointer argument!");
+        }
+    }
+}
+
+} // end namespace
+
+//======================================================================================================================
+
+dire_status dire_grid_create(size_t dim, const size_t* grid_size, size_t num_fields, size_t buff_size,
+                             dire_grid** grid)
+{
+    return guard([&]()
+    {
+        checkNotNull("dire_grid_create()", grid_size, grid);
+        *grid = nullptr;
+        if (dim == 0 || dim > DIRE_MAX_DIM)
+        {
+            throw std::invalid_argument("dire_grid_create(): Unsupported dimensionality!");
+        }
+        for (size_t i = 0; i < dim; ++i)
+        {
+            if (grid_size[i] == 0)
+            {
+                throw std::invalid_argument("All grid sizes have to be greater, than zero!");
+            }
+        }
+
+        switch (dim)
+        {
+        case 1: *grid = GridFactory<1, 1>::create(grid_size, num_fields, buff_size); break;
+        case 2: *grid = GridFactory<2, 1>::create(grid_size, num_fields, buff_size); break;
+        case 3: *grid = GridFactory<3, 1>::create(grid_size, num_fields, buff_size); break;
+        default: throw std::invalid_argument("dire_grid_create(): Unsupported dimensionality!");
+        }
+    });
+}
+
+void dire_grid_destroy(dire_grid* grid)
+{
+    delete grid;
+}
+
+dire_status dire_grid_get_layout(const dire_grid* grid, size_t* dim, size_t* num_fields)
+{
+    return guard([&]()
+    {
+        checkNotNull("dire_grid_get_layout()", grid, dim, num_fields);
+        *dim = grid->getDim();
+        *num_fields = grid->getNumFields();
+    });
+}
+
+dire_status dire_grid_add(dire_grid* grid, const size_t* cell_id, const double* fields)
+{
+    return guard([&]()
+    {
+        checkNotNull("dire_grid_add()", grid, cell_id, fields);
+        grid->add(cell_id, fields);
+    });
+}
+
+dire_status dire_grid_add_n(dire_grid* grid, size_t count, const size_t* cell_ids, const double* fields)
+{
+    return guard([&]()
+    {
+        if (count == 0)
+        {
+            return;
+        }
+
+        checkNotNull("dire_grid_add_n()", grid, cell_ids, fields);
+        const auto dim = grid->getDim();
+        const auto num_fields = grid->getNumFields();
+        for (size_t i = 0; i < count; ++i)
+        {
+            grid->add(cell_ids + i * dim, fields + i * num_fields);
+        }
+    });
+}
+
+dire_status dire_grid_clear(dire_grid* grid)
+{
+    return guard([&]()
+    {
+        checkNotNull("dire_grid_clear()", grid);
+        grid->clear();
+    });
+}
+
+dire_status dire_grid_compress(dire_grid* grid)
+{
+    return guard([&]()
+    {
+        checkNotNull("dire_grid_compress()", grid);
+        grid->compress();
+    });
+}
+
+dire_status dire_grid_get_view(const dire_grid* grid, dire_grid_view* view)
+{
+    if (grid != nullptr && !grid->isCompressed())
+    {
+        last_error = "dire_grid_get_view(): The grid has to be compressed!";
+        return DIRE_NOT_COMPRESSED;
+    }
+
+    return guard([&]()
+    {
+        checkNotNull("dire_grid_get_view()", grid, view);
+        *view = grid->getView();
+    });
+}
+
+const char* dire_get_last_error(void)
+{
+    return last_error.c_str();
+}
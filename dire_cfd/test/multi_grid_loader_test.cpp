@@ -0,0 +1,206 @@
+///
+/// @copyrightblock
+///
+///   NPOSL-3.0 License
+///
+///   Copyright(c) 2021 Mtys Lrnt-Nyeste
+///
+///   Licensed under the Non-Profit Open Software License, version 3.0 (the "License"); you may not use this file except
+///   in compliance with the License. You may obtain a copy of the License at:
+///
+///   https://opensource.org/licenses/NPOSL-3.0
+///
+///   Unless required by applicable law or agreed to in writing, software distributed under the License is distributed
+///   on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for
+///   the specific language governing permissionsand limitations under the License.
+///
+/// @endcopyrightblock
+///
+
+#include "test.hpp"
+
+#include "multi_grid_loader.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace {
+
+using Grid = dire::MultiGrid<2, float>;
+using Loader = dire::MultiGridLoader<2, float>;
+
+/// @brief The record of a node in the test streams.
+struct Record
+{
+    uint32_t x;
+    uint32_t y;
+    float value;
+};
+
+/// @brief The exception thrown by the failing parser.
+struct ParseError : std::runtime_error
+{
+    ParseError() : std::runtime_error("Invalid record!") {}
+};
+
+/// @brief Creates a stream of records, spread over a 17 x 5 grid.
+/// @param num_records The number of records.
+/// @return The bytes of the stream.
+std::string createRecords(uint32_t num_records)
+{
+    std::string bytes;
+    for (uint32_t i = 0; i < num_records; ++i)
+    {
+        const Record record{ i % 17, i % 5, float(i) };
+        bytes.append(reinterpret_cast<const char*>(&record), sizeof(record));
+    }
+    return bytes;
+}
+
+void parseRecord(const char* bytes, Grid::CellId& cell_id, float& value)
+{
+    Record record;
+    std::memcpy(&record, bytes, sizeof(record));
+    cell_id = { { record.x, record.y } };
+    value = record.value;
+}
+
+void testLoad()
+{
+    std::istringstream stream(createRecords(100003));
+    Grid grid(Grid::GridSize{ { 17, 5 } });
+    dire::ThreadPool pool(4);
+    const Loader loader(sizeof(Record), 1000);
+
+    CHECK(loader.load(stream, parseRecord, grid, pool) == 100003);
+    CHECK(grid.getNumData() == 100003);
+
+    // The records are binned in input order
+    grid.compress();
+    const auto bounds = grid.enumerateData({ { 3, 3 } });
+    float previous = -1;
+    for (auto it = bounds.begin; it != bounds.end; ++it)
+    {
+        CHECK(*it > previous);
+        previous = *it;
+    }
+}
+
+void testNarrowIndex()
+{
+    using NarrowGrid = dire::MultiGrid<2, float, uint32_t>;
+
+    std::istringstream stream(createRecords(10007));
+    NarrowGrid grid(NarrowGrid::GridSize{ { 17, 5 } });
+    dire::ThreadPool pool(2);
+    const dire::MultiGridLoader<2, float, uint32_t> loader(sizeof(Record), 1000);
+
+    const auto parse = [](const char* bytes, NarrowGrid::CellId& cell_id, float& value)
+    {
+        Record record;
+        std::memcpy(&record, bytes, sizeof(record));
+        cell_id = { { record.x, record.y } };
+        value = record.value;
+    };
+    CHECK(loader.load(stream, parse, grid, pool) == 10007);
+
+    grid.compress();
+    CHECK(grid.getNumData() == 10007);
+
+    // The records i = 3 (mod 85) are binned into the cell (3, 3)
+    CHECK(grid.getNumDataPerCell()[3 + 17 * 3] == (10007 - 3 + 84) / 85);
+}
+
+void testIncompleteRecord()
+{
+    const auto bytes = createRecords(1000);
+    std::istringstream stream(bytes.substr(0, bytes.size() - 3));
+    Grid grid(Grid::GridSize{ { 17, 5 } });
+    dire::ThreadPool pool(2);
+    const Loader loader(sizeof(Record), 100);
+
+    bool thrown = false;
+    try
+    {
+        loader.load(stream, parseRecord, grid, pool);
+    }
+    catch (const std::runtime_error&)
+    {
+        thrown = true;
+    }
+    CHECK(thrown);
+}
+
+void testInvalidCellId()
+{
+    std::istringstream stream(createRecords(1000));
+    Grid grid(Grid::GridSize{ { 16, 5 } });
+    dire::ThreadPool pool(2);
+    const Loader loader(sizeof(Record), 100);
+
+    bool thrown = false;
+    try
+    {
+        loader.load(stream, parseRecord, grid, pool);
+    }
+    catch (const std::out_of_range&)
+    {
+        thrown = true;
+    }
+    CHECK(thrown);
+}
+
+void testThrowingParser()
+{
+    const uint32_t failing_record = 5432;
+    std::istringstream stream(createRecords(20000));
+    Grid grid(Grid::GridSize{ { 17, 5 } });
+    dire::ThreadPool pool(4);
+    const Loader loader(sizeof(Record), 100);
+
+    // The parser lives on this stack frame, the loader must not return while a worker still uses it
+    std::atomic<size_t> num_parsed{ 0 };
+    const auto parse = [&](const char* bytes, Grid::CellId& cell_id, float& value)
+    {
+        parseRecord(bytes, cell_id, value);
+        if (value == float(failing_record))
+        {
+            throw ParseError();
+        }
+        ++num_parsed;
+    };
+
+    bool thrown = false;
+    try
+    {
+        loader.load(stream, parse, grid, pool);
+    }
+    catch (const ParseError&)
+    {
+        thrown = true;
+    }
+    CHECK(thrown);
+
+    // All chunks in flight have finished, and only the chunks before the failing one were binned
+    const auto num_parsed_on_return = num_parsed.load();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(num_parsed.load() == num_parsed_on_return);
+    CHECK(grid.getNumData() == failing_record / 100 * 100);
+}
+
+} // end namespace
+
+void testMultiGridLoader()
+{
+    testLoad();
+    testNarrowIndex();
+    testIncompleteRecord();
+    testInvalidCellId();
+    testThrowingParser();
+}
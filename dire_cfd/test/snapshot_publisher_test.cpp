@@ -0,0 +1,168 @@
+///
+/// @copyrightblock
+///
+///   NPOSL-3.0 License
+///
+///   Copyright(c) 2021 Mtys Lrnt-Nyeste
+///
+///   Licensed under the Non-Profit Open Software License, version 3.0 (the "License"); you may not use this file except
+///   in compliance with the License. You may obtain a copy of the License at:
+///
+///   https://opensource.org/licenses/NPOSL-3.0
+///
+///   Unless required by applicable law or agreed to in writing, software distributed under the License is distributed
+///   on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for
+///   the specific language governing permissionsand limitations under the License.
+///
+/// @endcopyrightblock
+///
+
+#include "test.hpp"
+
+#include "snapshot_publisher.hpp"
+
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
+#if defined(__cpp_impl_coroutine)
+#include <coroutine>
+#include <exception>
+#endif
+
+namespace {
+
+using Grid = dire::MultiGrid<1, int>;
+using Publisher = dire::SnapshotPublisher<1, int>;
+
+/// @brief Compresses and publishes a grid holding a single value.
+/// @param publisher The publisher.
+/// @param grid The grid, cleared by the publication.
+/// @param value The value.
+/// @return Whether the grid was published.
+bool publishValue(Publisher& publisher, Grid& grid, int value)
+{
+    grid.add({ { 0 } }, int(value));
+    grid.compress();
+    return publisher.publish(grid);
+}
+
+/// @brief Returns the value of a snapshot published by "publishValue()".
+int getValue(const Publisher::Snapshot& snapshot)
+{
+    return *snapshot->enumerateData({ { 0 } }).begin;
+}
+
+void testPublish()
+{
+    Publisher publisher(3);
+    Grid grid(Grid::GridSize{ { 1 } });
+    CHECK(!publisher.acquire());
+
+    CHECK(publishValue(publisher, grid, 1));
+    auto first = publisher.acquire();
+    CHECK(first && getValue(first) == 1);
+    CHECK(grid.getNumData() == 0);
+
+    // A held snapshot stays unchanged, while the slots not held are reused
+    CHECK(publishValue(publisher, grid, 2));
+    CHECK(publishValue(publisher, grid, 3));
+    CHECK(getValue(first) == 1);
+    CHECK(getValue(publisher.acquire()) == 3);
+
+    // All slots but the latest one held
+    auto latest = publisher.acquire();
+    CHECK(publishValue(publisher, grid, 4));
+    CHECK(!publishValue(publisher, grid, 5));
+    CHECK(grid.isCompressed() && getValue(latest) == 3);
+}
+
+#if defined(__cpp_impl_coroutine)
+/// @brief A coroutine started eagerly, signaling it's end through a future.
+struct Task
+{
+    struct promise_type
+    {
+        std::promise<void> done;
+
+        Task get_return_object() { return Task{ done.get_future() }; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() { done.set_value(); }
+        void unhandled_exception() { done.set_exception(std::current_exception()); }
+    };
+
+    std::future<void> done;
+};
+
+/// @brief Awaits the given number of publications, collecting their values, until the publisher is destroyed.
+Task readValues(const Publisher& publisher, dire::ThreadPool& pool, size_t num_values, std::vector<int>& values)
+{
+    Publisher::Snapshot snapshot;
+    while (values.size() < num_values)
+    {
+        snapshot = co_await publisher.acquireAsync(pool, snapshot);
+        if (!snapshot)
+        {
+            co_return;
+        }
+        values.push_back(getValue(snapshot));
+    }
+}
+
+void testAcquireAsync()
+{
+    dire::ThreadPool pool(2);
+
+    // Each awaited snapshot is newer, than the previous one
+    {
+        Publisher publisher;
+        Grid grid(Grid::GridSize{ { 1 } });
+        std::vector<int> values;
+        auto task = readValues(publisher, pool, 5, values);
+        for (int value = 1; task.done.wait_for(std::chrono::milliseconds(1)) != std::future_status::ready; ++value)
+        {
+            CHECK(publishValue(publisher, grid, value));
+        }
+        task.done.get();
+        CHECK(values.size() == 5);
+        for (size_t i = 1; i < values.size(); ++i)
+        {
+            CHECK(values[i] > values[i - 1]);
+        }
+    }
+
+    // An already published snapshot is returned without suspending
+    {
+        Publisher publisher;
+        Grid grid(Grid::GridSize{ { 1 } });
+        CHECK(publishValue(publisher, grid, 7));
+        std::vector<int> values;
+        readValues(publisher, pool, 1, values).done.get();
+        CHECK(values.size() == 1 && values[0] == 7);
+    }
+
+    // Destroying the publisher resumes the awaiting coroutines with a null snapshot
+    {
+        std::vector<int> values;
+        std::future<void> done;
+        {
+            Publisher publisher;
+            done = readValues(publisher, pool, 1, values).done;
+        }
+        done.get();
+        CHECK(values.empty());
+    }
+}
+#endif
+
+} // end namespace
+
+void testSnapshotPublisher()
+{
+    testPublish();
+#if defined(__cpp_impl_coroutine)
+    testAcquireAsync();
+#endif
+}
@@ -0,0 +1,42 @@
+///
+/// @copyrightblock
+///
+///   NPOSL-3.0 License
+///
+///   Copyright(c) 2021 Mtys Lrnt-Nyeste
+///
+///   Licensed under the Non-Profit Open Software License, version 3.0 (the "License"); you may not use this file except
+///   in compliance with the License. You may obtain a copy of the License at:
+///
+///   https://opensource.org/licenses/NPOSL-3.0
+///
+///   Unless required by applicable law or agreed to in writing, software distributed under the License is distributed
+///   on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for
+///   the specific language governing permissionsand limitations under the License.
+///
+/// @endcopyrightblock
+///
+
+#pragma once
+
+#include <cstdlib>
+#include <iostream>
+
+/// @brief Checks a condition, also in release builds, and fails the test with the location of the check, if it does
+///        not hold.
+#define CHECK(condition) check(condition, #condition, __FILE__, __LINE__)
+
+inline void check(bool condition, const char* expression, const char* file, int line)
+{
+    if (!condition)
+    {
+        std::cerr << "Check failed at " << file << ":" << line << ": " << expression << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+/// @brief Runs the tests of "MultiGridLoader".
+void testMultiGridLoader();
+
+/// @brief Runs the tests of "SnapshotPublisher".
+void testSnapshotPublisher();
@@ -0,0 +1,23 @@
+import sys
+
+from setuptools import Extension, setup
+
+# The extension is built on the C interface of the library
+extra_compile_args = ["/std:c++14"] if sys.platform == "win32" else ["-std=c++14"]
+
+setup(
+    name="dire_cfd",
+    version="0.1.0",
+    description="Python bindings of the DiRe-CFD library",
+    license="NPOSL-3.0 OR MIT",
+    python_requires=">=3.10",
+    ext_modules=[
+        Extension(
+            "dire_cfd",
+            sources=["source/dire_cfd_python.cpp", "../dire_cfd/source/dire_cfd_c.cpp"],
+            include_dirs=["../dire_cfd/include"],
+            extra_compile_args=extra_compile_args,
+            language="c++",
+        )
+    ],
+)
@@ -0,0 +1,630 @@
+///
+/// @copyrightblock
+///
+///   NPOSL-3.0 License
+///
+///   Copyright(c) 2021 Mtys Lrnt-Nyeste
+///
+///   Licensed under the Non-Profit Open Software License, version 3.0 (the "License"); you may not use this file except
+///   in compliance with the License. You may obtain a copy of the License at:
+///
+///   https://opensource.org/licenses/NPOSL-3.0
+///
+///   Unless required by applicable law or agreed to in writing, software distributed under the License is distributed
+///   on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for
+///   the specific language governing permissionsand limitations under the License.
+///
+/// @endcopyrightblock
+///
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include "dire_cfd_c.h"
+
+#include <cstring>
+
+namespace {
+
+/// @brief The buffer format of "size_t".
+constexpr const char* kSizeFormat = sizeof(size_t) == sizeof(unsigned long) ? "L" : "Q";
+
+/// @brief The Python object wrapping a grid handle.
+struct GridObject
+{
+    PyObject_HEAD
+    dire_grid* grid;                 ///< The handle of the wrapped grid
+    size_t dim;                      ///< The dimensionality of the grid
+    size_t num_fields;               ///< The number of doubles in the payload of a data
+    size_t grid_size[DIRE_MAX_DIM];  ///< The number of cells along each dimension
+    Py_ssize_t num_exports;          ///< The number of buffers exported from the compressed arrays
+};
+
+/// @brief The compressed arrays of a grid, that can be exported.
+enum class ArrayKind
+{
+    kData,        ///< The payloads, shaped (num_data, num_fields)
+    kCounts,      ///< The number of data per cell, shaped like the grid
+    kOffsets      ///< The id of the first data per cell, shaped like the grid
+};
+
+/// @brief A compressed array of a grid, exported through the buffer protocol without copying.
+struct GridArrayObject
+{
+    PyObject_HEAD
+    GridObject* grid;                ///< The grid owning the array
+    ArrayKind kind;                  ///< The exported array
+    Py_ssize_t shape[DIRE_MAX_DIM];  ///< The shape of the last exported buffer
+    Py_ssize_t strides[DIRE_MAX_DIM];///< The strides of the last exported buffer
+};
+
+extern PyTypeObject GridArrayType;
+
+/// @brief Raises the Python exception corresponding to a failed call of the C interface.
+/// @param status The status of the call.
+/// @return Null, for returning it from the calling function.
+PyObject* raiseStatus(dire_status status)
+{
+    PyObject* type = PyExc_RuntimeError;
+    switch (status)
+    {
+    case DIRE_INVALID_ARGUMENT: type = PyExc_ValueError; break;
+    case DIRE_OUT_OF_RANGE: type = PyExc_IndexError; break;
+    case DIRE_OUT_OF_MEMORY: type = PyExc_MemoryError; break;
+    default: break;
+    }
+    PyErr_SetString(type, dire_get_last_error());
+    return nullptr;
+}
+
+/// @brief Checks, that a grid was initialized, as "MultiGrid.__new__()" creates the object without a grid.
+/// @param self The grid.
+/// @return Whether the grid is initialized. Sets a "RuntimeError" otherwise.
+bool checkInitialized(GridObject* self)
+{
+    if (self->grid == nullptr)
+    {
+        PyErr_SetString(PyExc_RuntimeError, "The grid is not initialized!");
+        return false;
+    }
+    return true;
+}
+
+/// @brief Checks, that the compressed arrays of a grid are not exported, so the grid can be modified.
+/// @param self The grid.
+/// @return Whether the grid can be modified. Sets a "BufferError" otherwise.
+bool checkNotExported(GridObject* self)
+{
+    if (self->num_exports > 0)
+    {
+        PyErr_SetString(PyExc_BufferError, "The grid cannot be modified while it's arrays are exported!");
+        return false;
+    }
+    return true;
+}
+
+/// @brief Converts a Python sequence into an array of values.
+/// @param sequence The sequence.
+/// @param size The expected number of values.
+/// @param values Receives the values.
+/// @param convert Converts a Python object into a value, setting an exception on failure.
+/// @return Whether the conversion succeeded. Sets an exception otherwise.
+template <class Value, class Convert>
+bool toValues(PyObject* sequence, size_t size, Value* values, Convert convert)
+{
+    PyObject* fast = PySequence_Fast(sequence, "Expected a sequence!");
+    if (fast == nullptr)
+    {
+        return false;
+    }
+
+    bool success = static_cast<size_t>(PySequence_Fast_GET_SIZE(fast)) == size;
+    if (!success)
+    {
+        PyErr_SetString(PyExc_ValueError, "Invalid sequence length!");
+    }
+
+    for (size_t i = 0; success && i < size; ++i)
+    {
+        values[i] = convert(PySequence_Fast_GET_ITEM(fast, static_cast<Py_ssize_t>(i)));
+        success = !PyErr_Occurred();
+    }
+
+    Py_DECREF(fast);
+    return success;
+}
+
+/// @brief Acquires a C-contiguous buffer of items of a given type, holding a whole number of records.
+/// @param object The object exporting the buffer.
+/// @param floating Whether the items are doubles, or integers of the size of "size_t".
+/// @param record_size The number of items in a record.
+/// @param buffer Receives the buffer, to be released by "PyBuffer_Release()" on success.
+/// @return The number of records, or -1 on failure, setting an exception.
+Py_ssize_t getBuffer(PyObject* object, bool floating, size_t record_size, Py_buffer* buffer)
+{
+    if (PyObject_GetBuffer(object, buffer, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) != 0)
+    {
+        return -1;
+    }
+
+    const char* format = buffer->format[0] == '@' || buffer->format[0] == '=' ? buffer->format + 1 : buffer->format;
+    const bool valid_format = floating ? std::strcmp(format, "d") == 0
+                                       : buffer->itemsize == sizeof(size_t) && std::strlen(format) == 1
+                                             && std::strchr("lLqQnN", format[0]) != nullptr;
+    const auto num_items = static_cast<size_t>(buffer->len / buffer->itemsize);
+    if (!valid_format || num_items % record_size != 0)
+    {
+        PyErr_SetString(PyExc_ValueError, floating ? "Expected a contiguous buffer of doubles!"
+                                                   : "Expected a contiguous buffer of 64 bit integers!");
+        PyBuffer_Release(buffer);
+        return -1;
+    }
+    return static_cast<Py_ssize_t>(num_items / record_size);
+}
+
+//======================================================================================================================
+
+int gridInit(GridObject* self, PyObject* args, PyObject* kwargs)
+{
+    static const char* keywords[] = { "grid_size", "num_fields", "buff_size", nullptr };
+    PyObject* grid_size = nullptr;
+    Py_ssize_t num_fields = 0;
+    Py_ssize_t buff_size = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "On|n", const_cast<char**>(keywords), &grid_size, &num_fields,
+                                     &buff_size))
+    {
+        return -1;
+    }
+
+    if (self->grid != nullptr)
+    {
+        PyErr_SetString(PyExc_RuntimeError, "The grid is already initialized!");
+        return -1;
+    }
+
+    const auto dim = PySequence_Check(grid_size) ? PySequence_Size(grid_size) : -1;
+    if (dim < 1 || dim > DIRE_MAX_DIM || num_fields < 1 || buff_size < 0)
+    {
+        PyErr_SetString(PyExc_ValueError, "Unsupported dimensionality or number of fields!");
+        return -1;
+    }
+
+    self->dim = static_cast<size_t>(dim);
+    self->num_fields = static_cast<size_t>(num_fields);
+    if (!toValues(grid_size, self->dim, self->grid_size, PyLong_AsSize_t))
+    {
+        return -1;
+    }
+
+    const auto status = dire_grid_create(self->dim, self->grid_size, self->num_fields,
+                                         static_cast<size_t>(buff_size), &self->grid);
+    if (status != DIRE_OK)
+    {
+        raiseStatus(status);
+        return -1;
+    }
+    return 0;
+}
+
+void gridDealloc(GridObject* self)
+{
+    dire_grid_destroy(self->grid);
+    Py_TYPE(self)->tp_free(reinterpret_cast<PyObject*>(self));
+}
+
+PyObject* gridAdd(GridObject* self, PyObject* args)
+{
+    PyObject* cell_id_object = nullptr;
+    PyObject* fields_object = nullptr;
+    if (!checkInitialized(self) || !checkNotExported(self)
+        || !PyArg_ParseTuple(args, "OO", &cell_id_object, &fields_object))
+    {
+        return nullptr;
+    }
+
+    size_t cell_id[DIRE_MAX_DIM];
+    double fields[DIRE_MAX_NUM_FIELDS];
+    if (!toValues(cell_id_object, self->dim, cell_id, PyLong_AsSize_t)
+        || !toValues(fields_object, self->num_fields, fields, PyFloat_AsDouble))
+    {
+        return nullptr;
+    }
+
+    const auto status = dire_grid_add(self->grid, cell_id, fields);
+    return status == DIRE_OK ? Py_NewRef(Py_None) : raiseStatus(status);
+}
+
+PyObject* gridAddMany(GridObject* self, PyObject* args)
+{
+    PyObject* cell_ids_object = nullptr;
+    PyObject* fields_object = nullptr;
+    if (!checkInitialized(self) || !checkNotExported(self)
+        || !PyArg_ParseTuple(args, "OO", &cell_ids_object, &fields_object))
+    {
+        return nullptr;
+    }
+
+    Py_buffer cell_ids;
+    const auto count = getBuffer(cell_ids_object, false, self->dim, &cell_ids);
+    if (count < 0)
+    {
+        return nullptr;
+    }
+
+    Py_buffer fields;
+    if (getBuffer(fields_object, true, self->num_fields, &fields) != count)
+    {
+        if (!PyErr_Occurred())
+        {
+            PyBuffer_Release(&fields);
+            PyErr_SetString(PyExc_ValueError, "MultiGrid.add_many(): The number of cell ids and fields differ!");
+        }
+        PyBuffer_Release(&cell_ids);
+        return nullptr;
+    }
+
+    const auto status = dire_grid_add_n(self->grid, static_cast<size_t>(count),
+                                        static_cast<const size_t*>(cell_ids.buf),
+                                        static_cast<const double*>(fields.buf));
+
+    PyBuffer_Release(&cell_ids);
+    PyBuffer_Release(&fields);
+    return status == DIRE_OK ? Py_NewRef(Py_None) : raiseStatus(status);
+}
+
+PyObject* gridClear(GridObject* self, PyObject*)
+{
+    if (!checkInitialized(self) || !checkNotExported(self))
+    {
+        return nullptr;
+    }
+
+    const auto status = dire_grid_clear(self->grid);
+    return status == DIRE_OK ? Py_NewRef(Py_None) : raiseStatus(status);
+}
+
+PyObject* gridCompress(GridObject* self, PyObject*)
+{
+    if (!checkInitialized(self) || !checkNotExported(self))
+    {
+        return nullptr;
+    }
+
+    const auto status = dire_grid_compress(self->grid);
+    return status == DIRE_OK ? Py_NewRef(Py_None) : raiseStatus(status);
+}
+
+PyObject* gridQuery(GridObject* self, PyObject* args)
+{
+    PyObject* cell_ids_object = nullptr;
+    if (!checkInitialized(self) || !PyArg_ParseTuple(args, "O", &cell_ids_object))
+    {
+        return nullptr;
+    }
+
+    dire_grid_view view;
+    const auto status = dire_grid_get_view(self->grid, &view);
+    if (status != DIRE_OK)
+    {
+        return raiseStatus(status);
+    }
+
+    Py_buffer cell_ids;
+    const auto count = getBuffer(cell_ids_object, false, self->dim, &cell_ids);
+    if (count < 0)
+    {
+        return nullptr;
+    }
+
+    if (count == 0)
+    {
+        // "memoryview.cast()" rejects shapes with a zero, so the empty view is described directly, over no memory
+        PyBuffer_Release(&cell_ids);
+        static char empty;
+        Py_ssize_t shape[2] = { 0, 2 };
+        Py_ssize_t strides[2] = { 2 * static_cast<Py_ssize_t>(sizeof(size_t)), sizeof(size_t) };
+        Py_buffer buffer = {};
+        buffer.buf = &empty;
+        buffer.itemsize = sizeof(size_t);
+        buffer.readonly = 1;
+        buffer.ndim = 2;
+        buffer.format = const_cast<char*>(kSizeFormat);
+        buffer.shape = shape;
+        buffer.strides = strides;
+        return PyMemoryView_FromBuffer(&buffer);
+    }
+
+    // The data id bounds of each queried cell, as (count, 2) array
+    PyObject* bytes = PyByteArray_FromStringAndSize(nullptr, count * 2 * static_cast<Py_ssize_t>(sizeof(size_t)));
+    if (bytes == nullptr)
+    {
+        PyBuffer_Release(&cell_ids);
+        return nullptr;
+    }
+
+    const auto* ids = static_cast<const size_t*>(cell_ids.buf);
+    auto* bounds = reinterpret_cast<size_t*>(PyByteArray_AS_STRING(bytes));
+    bool valid = true;
+    for (size_t i = 0; valid && i < static_cast<size_t>(count); ++i)
+    {
+        // Axis 0 is the fastest varying
+        size_t storage_id = 0;
+        for (size_t j = self->dim; j-- > 0;)
+        {
+            const auto cell_id = ids[i * self->dim + j];
+            valid = valid && cell_id < self->grid_size[j];
+            storage_id = storage_id * self->grid_size[j] + cell_id;
+        }
+        if (valid)
+        {
+            bounds[2 * i] = view.first_data_id_per_cell[storage_id];
+            bounds[2 * i + 1] = bounds[2 * i] + view.num_data_per_cell[storage_id];
+        }
+    }
+    PyBuffer_Release(&cell_ids);
+
+    if (!valid)
+    {
+        Py_DECREF(bytes);
+        PyErr_SetString(PyExc_IndexError, "MultiGrid.query(): Invalid cell id!");
+        return nullptr;
+    }
+
+    PyObject* memory_view = PyMemoryView_FromObject(bytes);
+    Py_DECREF(bytes);
+    if (memory_view == nullptr)
+    {
+        return nullptr;
+    }
+
+    PyObject* result = PyObject_CallMethod(memory_view, "cast", "s(nn)", kSizeFormat, count, Py_ssize_t(2));
+    Py_DECREF(memory_view);
+    return result;
+}
+
+PyObject* gridGetArray(GridObject* self, void* closure)
+{
+    if (!checkInitialized(self))
+    {
+        return nullptr;
+    }
+
+    auto* array = PyObject_New(GridArrayObject, &GridArrayType);
+    if (array == nullptr)
+    {
+        return nullptr;
+    }
+
+    array->grid = reinterpret_cast<GridObject*>(Py_NewRef(reinterpret_cast<PyObject*>(self)));
+    array->kind = static_cast<ArrayKind>(reinterpret_cast<Py_intptr_t>(closure));
+    return reinterpret_cast<PyObject*>(array);
+}
+
+PyObject* gridGetGridSize(GridObject* self, void*)
+{
+    if (!checkInitialized(self))
+    {
+        return nullptr;
+    }
+
+    PyObject* grid_size = PyTuple_New(static_cast<Py_ssize_t>(self->dim));
+    for (size_t i = 0; grid_size != nullptr && i < self->dim; ++i)
+    {
+        PyTuple_SET_ITEM(grid_size, static_cast<Py_ssize_t>(i), PyLong_FromSize_t(self->grid_size[i]));
+    }
+    return grid_size;
+}
+
+PyObject* gridGetNumFields(GridObject* self, void*)
+{
+    if (!checkInitialized(self))
+    {
+        return nullptr;
+    }
+
+    return PyLong_FromSize_t(self->num_fields);
+}
+
+PyObject* gridIsCompressed(GridObject* self, void*)
+{
+    if (!checkInitialized(self))
+    {
+        return nullptr;
+    }
+
+    dire_grid_view view;
+    return PyBool_FromLong(dire_grid_get_view(self->grid, &view) == DIRE_OK);
+}
+
+PyMethodDef grid_methods[] = {
+    { "add", reinterpret_cast<PyCFunction>(gridAdd), METH_VARARGS,
+      "add(cell_id, fields)\n\nAdds a data to a cell. Makes the grid uncompressed." },
+    { "add_many", reinterpret_cast<PyCFunction>(gridAddMany), METH_VARARGS,
+      "add_many(cell_ids, fields)\n\nAdds data from two contiguous buffers: 64 bit cell ids shaped (count, dim), and "
+      "doubles shaped (count, num_fields). Makes the grid uncompressed." },
+    { "clear", reinterpret_cast<PyCFunction>(gridClear), METH_NOARGS,
+      "clear()\n\nClears all buffered data. Makes the grid uncompressed." },
+    { "compress", reinterpret_cast<PyCFunction>(gridCompress), METH_NOARGS,
+      "compress()\n\nConverts the grid into the compressed format." },
+    { "query", reinterpret_cast<PyCFunction>(gridQuery), METH_VARARGS,
+      "query(cell_ids)\n\nReturns the data id bounds [begin, end) of each cell of a contiguous buffer of 64 bit cell "
+      "ids shaped (count, dim), as a memoryview shaped (count, 2). The grid has to be compressed." },
+    { nullptr, nullptr, 0, nullptr }
+};
+
+PyGetSetDef grid_getsets[] = {
+    { "data", reinterpret_cast<getter>(gridGetArray), nullptr,
+      "The payloads in the compressed order, exported as doubles shaped (num_data, num_fields).",
+      reinterpret_cast<void*>(static_cast<Py_intptr_t>(ArrayKind::kData)) },
+    { "counts", reinterpret_cast<getter>(gridGetArray), nullptr,
+      "The number of data in each cell, exported shaped like the grid.",
+      reinterpret_cast<void*>(static_cast<Py_intptr_t>(ArrayKind::kCounts)) },
+    { "offsets", reinterpret_cast<getter>(gridGetArray), nullptr,
+      "The id of the first data of each cell, exported shaped like the grid.",
+      reinterpret_cast<void*>(static_cast<Py_intptr_t>(ArrayKind::kOffsets)) },
+    { "grid_size", reinterpret_cast<getter>(gridGetGridSize), nullptr, "The number of cells along each dimension.",
+      nullptr },
+    { "num_fields", reinterpret_cast<getter>(gridGetNumFields), nullptr,
+      "The number of doubles in the payload of a data.", nullptr },
+    { "is_compressed", reinterpret_cast<getter>(gridIsCompressed), nullptr, "Whether the grid is compressed.",
+      nullptr },
+    { nullptr, nullptr, nullptr, nullptr, nullptr }
+};
+
+PyTypeObject GridType = { PyVarObject_HEAD_INIT(nullptr, 0) };
+
+//======================================================================================================================
+
+void gridArrayDealloc(GridArrayObject* self)
+{
+    Py_DECREF(reinterpret_cast<PyObject*>(self->grid));
+    PyObject_Free(self);
+}
+
+int gridArrayGetBuffer(GridArrayObject* self, Py_buffer* buffer, int flags)
+{
+    if ((flags & PyBUF_WRITABLE) == PyBUF_WRITABLE)
+    {
+        PyErr_SetString(PyExc_BufferError, "The arrays of the grid are read-only!");
+        return -1;
+    }
+
+    dire_grid_view view;
+    const auto status = dire_grid_get_view(self->grid->grid, &view);
+    if (status != DIRE_OK)
+    {
+        PyErr_SetString(PyExc_BufferError, dire_get_last_error());
+        return -1;
+    }
+
+    const void* data = nullptr;
+    if (self->kind == ArrayKind::kData)
+    {
+        data = view.data;
+        buffer->itemsize = sizeof(double);
+        buffer->format = const_cast<char*>("d");
+        buffer->ndim = 2;
+        self->shape[0] = static_cast<Py_ssize_t>(view.num_data);
+        self->shape[1] = static_cast<Py_ssize_t>(view.num_fields);
+        self->strides[0] = static_cast<Py_ssize_t>(view.num_fields * sizeof(double));
+        self->strides[1] = sizeof(double);
+    }
+    else
+    {
+        // Shaped like the grid, axis 0 being the fastest varying (Fortran order)
+        data = self->kind == ArrayKind::kCounts ? view.num_data_per_cell : view.first_data_id_per_cell;
+        buffer->itemsize = sizeof(size_t);
+        buffer->format = const_cast<char*>(kSizeFormat);
+        buffer->ndim = static_cast<int>(self->grid->dim);
+        Py_ssize_t stride = sizeof(size_t);
+        for (size_t i = 0; i < self->grid->dim; ++i)
+        {
+            self->shape[i] = static_cast<Py_ssize_t>(self->grid->grid_size[i]);
+            self->strides[i] = stride;
+            stride *= self->shape[i];
+        }
+    }
+
+    buffer->buf = const_cast<void*>(data);
+    buffer->readonly = 1;
+    buffer->len = buffer->itemsize;
+    for (int i = 0; i < buffer->ndim; ++i)
+    {
+        buffer->len *= self->shape[i];
+    }
+    buffer->shape = self->shape;
+    buffer->strides = self->strides;
+    buffer->suboffsets = nullptr;
+    buffer->internal = nullptr;
+
+    // The counts and offsets of a multidimensional grid are only Fortran contiguous, which requires their strides
+    const bool c_contiguous = PyBuffer_IsContiguous(buffer, 'C') != 0;
+    const bool f_contiguous = PyBuffer_IsContiguous(buffer, 'F') != 0;
+    if (((flags & PyBUF_C_CONTIGUOUS) == PyBUF_C_CONTIGUOUS && !c_contiguous)
+        || ((flags & PyBUF_F_CONTIGUOUS) == PyBUF_F_CONTIGUOUS && !f_contiguous)
+        || ((flags & PyBUF_STRIDES) != PyBUF_STRIDES && !c_contiguous))
+    {
+        PyErr_SetString(PyExc_BufferError, "The array is not contiguous in the requested order!");
+        return -1;
+    }
+
+    if ((flags & PyBUF_STRIDES) != PyBUF_STRIDES)
+    {
+        buffer->strides = nullptr;
+    }
+    if ((flags & PyBUF_ND) != PyBUF_ND)
+    {
+        buffer->ndim = 1;
+        buffer->shape = nullptr;
+    }
+    if ((flags & PyBUF_FORMAT) != PyBUF_FORMAT)
+    {
+        buffer->format = nullptr;
+    }
+
+    buffer->obj = Py_NewRef(reinterpret_cast<PyObject*>(self));
+
+    ++self->grid->num_exports;
+    return 0;
+}
+
+void gridArrayReleaseBuffer(GridArrayObject* self, Py_buffer*)
+{
+    --self->grid->num_exports;
+}
+
+PyBufferProcs grid_array_buffer_procs = {
+    reinterpret_cast<getbufferproc>(gridArrayGetBuffer),
+    reinterpret_cast<releasebufferproc>(gridArrayReleaseBuffer)
+};
+
+PyTypeObject GridArrayType = { PyVarObject_HEAD_INIT(nullptr, 0) };
+
+PyModuleDef module_def = { PyModuleDef_HEAD_INIT };
+
+} // end namespace
+
+PyMODINIT_FUNC PyInit_dire_cfd()
+{
+    GridType.tp_name = "dire_cfd.MultiGrid";
+    GridType.tp_basicsize = sizeof(GridObject);
+    GridType.tp_flags = Py_TPFLAGS_DEFAULT;
+    GridType.tp_doc = "MultiGrid(grid_size, num_fields, buff_size=0)\n\n"
+                      "A grid holding multiple data in each cell, the payload of a data being \"num_fields\" doubles. "
+                      "The compressed arrays are exported through the buffer protocol without copying; the grid "
+                      "cannot be modified while they are exported.";
+    GridType.tp_new = PyType_GenericNew;
+    GridType.tp_init = reinterpret_cast<initproc>(gridInit);
+    GridType.tp_dealloc = reinterpret_cast<destructor>(gridDealloc);
+    GridType.tp_methods = grid_methods;
+    GridType.tp_getset = grid_getsets;
+
+    GridArrayType.tp_name = "dire_cfd.GridArray";
+    GridArrayType.tp_basicsize = sizeof(GridArrayObject);
+    GridArrayType.tp_flags = Py_TPFLAGS_DEFAULT;
+    GridArrayType.tp_doc = "A compressed array of a MultiGrid, exported through the buffer protocol.";
+    GridArrayType.tp_dealloc = reinterpret_cast<destructor>(gridArrayDealloc);
+    GridArrayType.tp_as_buffer = &grid_array_buffer_procs;
+
+    module_def.m_name = "dire_cfd";
+    module_def.m_doc = "Python bindings of the DiRe-CFD library.";
+    module_def.m_size = -1;
+
+    if (PyType_Ready(&GridType) < 0 || PyType_Ready(&GridArrayType) < 0)
+    {
+        return nullptr;
+    }
+
+    PyObject* module = PyModule_Create(&module_def);
+    if (module == nullptr)
+    {
+        return nullptr;
+    }
+
+    if (PyModule_AddObjectRef(module, "MultiGrid", reinterpret_cast<PyObject*>(&GridType)) < 0)
+    {
+        Py_DECREF(module);
+        return nullptr;
+    }
+    return module;
+}
@@ -0,0 +1,119 @@
+"""Tests of the Python bindings, run after building the extension in place:
+
+    python setup.py build_ext --inplace
+    python -m unittest discover -s tests
+"""
+
+import array
+import hashlib
+import unittest
+
+import dire_cfd
+
+
+def cell_ids(*values):
+    """Returns a buffer of 64 bit cell ids."""
+    return array.array("q", values)
+
+
+def fields(*values):
+    """Returns a buffer of doubles."""
+    return array.array("d", values)
+
+
+class MultiGridTest(unittest.TestCase):
+    def create_grid(self):
+        """Creates a compressed 3 x 2 grid of 4 data with 2 fields each."""
+        grid = dire_cfd.MultiGrid((3, 2), 2)
+        grid.add((2, 1), (1.0, 2.0))
+        grid.add([0, 0], [3.0, 4.0])
+        grid.add_many(cell_ids(2, 1, 1, 0), fields(5.0, 6.0, 7.0, 8.0))
+        grid.compress()
+        return grid
+
+    def test_add_many(self):
+        grid = self.create_grid()
+        self.assertEqual(grid.grid_size, (3, 2))
+        self.assertEqual(grid.num_fields, 2)
+        self.assertTrue(grid.is_compressed)
+
+        with memoryview(grid.data) as data:
+            self.assertEqual(data.tolist(), [[3.0, 4.0], [7.0, 8.0], [1.0, 2.0], [5.0, 6.0]])
+
+        grid.add_many(cell_ids(0, 0), fields(9.0, 10.0))
+        self.assertFalse(grid.is_compressed)
+        with self.assertRaises(ValueError):
+            grid.add_many(cell_ids(0, 0), fields(1.0))
+        with self.assertRaises(ValueError):
+            grid.add_many(cell_ids(0, 0, 1), fields(1.0, 2.0))
+        with self.assertRaises(IndexError):
+            grid.add_many(cell_ids(3, 0), fields(1.0, 2.0))
+
+    def test_query(self):
+        grid = self.create_grid()
+        bounds = grid.query(cell_ids(2, 1, 0, 0, 2, 0))
+        self.assertEqual(bounds.shape, (3, 2))
+        self.assertEqual(bounds.tolist(), [[2, 4], [0, 1], [2, 2]])
+
+        with self.assertRaises(IndexError):
+            grid.query(cell_ids(3, 0))
+
+    def test_empty_query(self):
+        grid = self.create_grid()
+        bounds = grid.query(cell_ids())
+        self.assertEqual(bounds.shape, (0, 2))
+        self.assertEqual(bounds.tolist(), [])
+
+    def test_views(self):
+        grid = self.create_grid()
+        with memoryview(grid.counts) as counts, memoryview(grid.offsets) as offsets:
+            # Shaped like the grid, axis 0 being the fastest varying
+            self.assertEqual(counts.shape, (3, 2))
+            self.assertTrue(counts.f_contiguous)
+            self.assertTrue(counts.readonly)
+            self.assertEqual(counts.tolist(), [[1, 0], [1, 0], [0, 2]])
+            self.assertEqual(offsets.tolist(), [[0, 2], [1, 2], [2, 2]])
+
+            # The grid cannot be modified while it's arrays are exported
+            with self.assertRaises(BufferError):
+                grid.clear()
+
+        # Hashing requests a simple buffer, which the Fortran ordered arrays cannot meet without strides
+        with self.assertRaises(BufferError):
+            hashlib.sha256(grid.counts)
+        with self.assertRaises(BufferError):
+            hashlib.sha256(grid.offsets)
+        expected = hashlib.sha256(fields(3.0, 4.0, 7.0, 8.0, 1.0, 2.0, 5.0, 6.0)).digest()
+        self.assertEqual(hashlib.sha256(grid.data).digest(), expected)
+
+        # The failed requests did not leave the arrays exported
+        grid.clear()
+
+        with self.assertRaises(BufferError):
+            memoryview(grid.data)
+
+    def test_view_outlives_grid(self):
+        data = self.create_grid().data
+        with memoryview(data) as view:
+            self.assertEqual(view.tolist()[0], [3.0, 4.0])
+
+    def test_uninitialized(self):
+        grid = dire_cfd.MultiGrid.__new__(dire_cfd.MultiGrid)
+        calls = [
+            lambda: grid.add((0,), (1.0,)),
+            lambda: grid.add_many(cell_ids(), fields()),
+            lambda: grid.clear(),
+            lambda: grid.compress(),
+            lambda: grid.query(cell_ids()),
+            lambda: grid.data,
+            lambda: grid.grid_size,
+            lambda: grid.num_fields,
+            lambda: grid.is_compressed,
+        ]
+        for call in calls:
+            with self.assertRaises(RuntimeError):
+                call()
+
+
+if __name__ == "__main__":
+    unittest.main()